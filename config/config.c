@@ -89,6 +89,10 @@ Settings config = {
     .element_height    =                                   1,
     /** Sidebar mode, show the modi */
     .sidebar_mode      = FALSE,
+    /** Delay filtering on lists longer than this. */
+    .lazy_filter_limit =                                5000,
+    /** Filter on likely next characters while idle. */
+    .speculate         = FALSE,
     /** auto select */
     .auto_select       = FALSE,
     /** Parse /etc/hosts file in ssh view. */
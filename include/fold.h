@@ -0,0 +1,103 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef ROFI_FOLD_H
+#define ROFI_FOLD_H
+#include <glib.h>
+
+/**
+ * @defgroup FOLD Fold
+ * @ingroup HELPERS
+ *
+ * Case folded copy of the primary string of each row, stored in one block of memory.
+ *
+ * Case insensitive scoring otherwise folds every character of a row again for each input.
+ * A character is only folded when its folded form has the same length in bytes, so byte offsets
+ * in the copy are the same as in the original string. Rows with a character that cannot be folded
+ * that way (e.g. KELVIN SIGN to 'k') are left out, callers fall back to the original string for those.
+ *
+ * @{
+ */
+
+/**
+ * The folded strings.
+ */
+typedef struct _RofiFoldCorpus   RofiFoldCorpus;
+
+/**
+ * @param row The row.
+ * @param user_data The user data passed to rofi_fold_corpus_new()
+ *
+ * Get the primary string of a row. This is called from the worker threads.
+ *
+ * @returns the string, NULL if the row has none.
+ */
+typedef const char * ( *RofiFoldTextFunc )( unsigned int row, gpointer user_data );
+
+/**
+ * @param num_rows The number of rows.
+ * @param func Function to get the string of a row.
+ * @param user_data Passed to func.
+ * @param cancel Set to non-zero (from any thread) to stop building, NULL if not used.
+ *
+ * Fold the strings of all rows, spread over the workers.
+ *
+ * @returns the folded strings, free with rofi_fold_corpus_free(), or NULL when cancelled.
+ */
+RofiFoldCorpus * rofi_fold_corpus_new ( unsigned int num_rows, RofiFoldTextFunc func, gpointer user_data, const gint *cancel );
+
+/**
+ * @param corpus The folded strings to free.
+ *
+ * Free the folded strings.
+ */
+void rofi_fold_corpus_free ( RofiFoldCorpus *corpus );
+
+/**
+ * @param corpus The folded strings.
+ * @param row The row.
+ *
+ * @returns the folded string of the row, or NULL if it could not be folded keeping the byte offsets.
+ */
+const char * rofi_fold_corpus_get ( const RofiFoldCorpus *corpus, unsigned int row );
+
+/**
+ * @param c The character to fold.
+ *
+ * Simple case folding, all case variants of a character fold to the same character.
+ * (e.g. 'K', 'k' and KELVIN SIGN all fold to 'k')
+ *
+ * @returns the folded character.
+ */
+static inline gunichar rofi_fold_char ( gunichar c )
+{
+    return g_unichar_tolower ( g_unichar_toupper ( c ) );
+}
+
+/**@}*/
+#endif // ROFI_FOLD_H
@@ -29,10 +29,42 @@
 #define ROFI_HELPER_THEME_H
 #include <pango/pango.h>
 #include "theme.h"
+#include "rofi-types.h"
 /**
  * @defgroup HELPERS Helpers
  * @{
  */
+/**
+ * A matched part of a string, the bytes [start, end).
+ */
+typedef struct
+{
+    int start;
+    int end;
+} rofi_match_span;
+
+/**
+ * @param tokens Array of regexes used for matching
+ * @param input The input string to find the matches on
+ *
+ * Find the parts of the input string matched by the tokens, to highlight them.
+ * Plain substring tokens are searched natively, without the regex.
+ *
+ * @returns a new array of #rofi_match_span, free with g_array_free()
+ */
+GArray *helper_token_match_get_spans ( rofi_int_matcher **tokens, const char *input );
+
+/**
+ * @param th The ThemeHighlight
+ * @param spans Array of #rofi_match_span
+ * @param retv The Attribute list to update with matches
+ *
+ * Creates a set of pango attributes highlighting the spans.
+ *
+ * @returns the updated retv list.
+ */
+PangoAttrList *helper_match_spans_get_pango_attr ( ThemeHighlight th, const GArray *spans, PangoAttrList *retv );
+
 /**
  * @param th The ThemeHighlight
  * @param tokens Array of regexes used for matching
@@ -43,7 +75,7 @@
  *
  * @returns the updated retv list.
  */
-PangoAttrList *helper_token_match_get_pango_attr ( ThemeHighlight th, GRegex **tokens, const char *input, PangoAttrList *retv );
+PangoAttrList *helper_token_match_get_pango_attr ( ThemeHighlight th, rofi_int_matcher **tokens, const char *input, PangoAttrList *retv );
 
 /**
  * @param pfd Pango font description to validate.
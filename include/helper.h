@@ -27,6 +27,7 @@
 
 #ifndef ROFI_HELPER_H
 #define ROFI_HELPER_H
+#include "rofi-types.h"
 /**
  * @defgroup HELPERS Helpers
  */
@@ -56,14 +57,19 @@ int helper_parse_setup ( char * string, char ***output, int *length, ... );
  *
  * @returns a newly allocated array of regex objest
  */
-GRegex **tokenize ( const char *input, int case_sensitive );
+rofi_int_matcher **tokenize ( const char *input, int case_sensitive );
 
 /**
  * @param tokens Array of regex objects
  *
  * Frees the array of regex expressions.
  */
-void tokenize_free ( GRegex ** tokens );
+void tokenize_free ( rofi_int_matcher **tokens );
+
+/**
+ * Release the compiled tokens tokenize() keeps for reuse.
+ */
+void tokenize_cache_clear ( void );
 
 /**
  * @param key The key to search for
@@ -131,7 +137,41 @@ int find_arg ( const char * const key );
  *
  * @returns TRUE when matches, FALSE otherwise
  */
-int helper_token_match ( GRegex * const *tokens, const char *input );
+int helper_token_match ( rofi_int_matcher * const *tokens, const char *input );
+
+/**
+ * @param matches Bitmap with one bit per entry.
+ * @param bit     Index of the entry in the bitmap.
+ *
+ * Mark an entry as matching in the bitmap filled by mode_token_match_range().
+ */
+static inline void helper_match_bitmap_set ( guint32 *matches, unsigned int bit )
+{
+    matches[bit / 32] |= ( 1u << ( bit % 32 ) );
+}
+
+/**
+ * @param matches Bitmap with one bit per entry.
+ * @param bit     Index of the entry in the bitmap.
+ *
+ * @returns TRUE if the entry is marked as matching.
+ */
+static inline gboolean helper_match_bitmap_get ( const guint32 *matches, unsigned int bit )
+{
+    return ( matches[bit / 32] >> ( bit % 32 ) ) & 1u;
+}
+
+/**
+ * @param tokens  List of (input) tokens to match.
+ * @param rows    The entries to match against.
+ * @param start   The first entry to match.
+ * @param stop    The entry after the last entry to match.
+ * @param matches Cleared bitmap, bit (i - start) is set when rows[i] matches. [out]
+ *
+ * Tokenized match of a range of entries, gives the same result as helper_token_match() on each entry.
+ * The first token is matched against all entries, each next token only against the entries that are left.
+ */
+void helper_token_match_range ( rofi_int_matcher * const *tokens, char * const *rows, unsigned int start, unsigned int stop, guint32 *matches );
 /**
  * @param cmd The command to execute.
  *
@@ -200,6 +240,52 @@ char *rofi_expand_path ( const char *input );
  */
 unsigned int levenshtein ( const char *needle, const glong needlelen, const char *haystack, const glong haystacklen );
 
+/**
+ * Needle prepared for levenshtein_needle_distance().
+ */
+typedef struct _LevenshteinNeedle   LevenshteinNeedle;
+
+/**
+ * @param needle The string to find match weight off
+ * @param needlelen The length of the needle
+ * @param case_sensitive Whether case is significant.
+ *
+ * Decode and (if case insensitive) lower case the needle once, so it can be matched against many haystacks.
+ *
+ * @returns a new LevenshteinNeedle, free with levenshtein_needle_free().
+ */
+LevenshteinNeedle *levenshtein_needle_new ( const char *needle, glong needlelen, int case_sensitive );
+
+/**
+ * @param n The needle to free, can be NULL.
+ *
+ * Free the prepared needle.
+ */
+void levenshtein_needle_free ( LevenshteinNeedle *n );
+
+/**
+ * @param n The prepared needle.
+ * @param haystack The string to match against
+ * @param haystacklen The length of the haystack
+ *
+ * UTF-8 aware levenshtein distance calculation, using a bit-parallel algorithm.
+ * Can be called from multiple threads on the same needle.
+ *
+ * @returns the levenshtein distance between needle and haystack
+ */
+unsigned int levenshtein_needle_distance ( const LevenshteinNeedle *n, const char *haystack, glong haystacklen );
+
+/**
+ * @param n The prepared needle.
+ * @param folded The case folded string to match against, see rofi_fold_corpus_get().
+ * @param haystacklen The length of the haystack
+ *
+ * Like levenshtein_needle_distance(), but skips folding the haystack.
+ *
+ * @returns the levenshtein distance between needle and haystack
+ */
+unsigned int levenshtein_needle_distance_folded ( const LevenshteinNeedle *n, const char *folded, glong haystacklen );
+
 /**
  * @param data the unvalidated character array holding possible UTF-8 data
  * @param length the length of the data array
@@ -225,12 +311,27 @@ char * rofi_latin_to_utf8_strdup ( const char *input, gssize length );
  * @param plen      Pattern length.
  * @param str       The input to match against pattern.
  * @param slen      Lenght of str.
+ * @param case_sensitive Whether case is significant.
  *
  * FZF like fuzzy sorting algorithm.
  *
  * @returns the sorting weight.
  */
-int rofi_scorer_fuzzy_evaluate ( const char *pattern, glong plen, const char *str, glong slen );
+int rofi_scorer_fuzzy_evaluate ( const char *pattern, glong plen, const char *str, glong slen, int case_sensitive );
+
+/**
+ * @param pattern   The user input to match against.
+ * @param plen      Pattern length.
+ * @param str       The input to match against pattern.
+ * @param folded    str case folded with the same byte offsets, see rofi_fold_corpus_get().
+ * @param slen      Lenght of str.
+ * @param case_sensitive Whether case is significant.
+ *
+ * Like rofi_scorer_fuzzy_evaluate(), but takes the folded characters from folded instead of folding str again.
+ *
+ * @returns the sorting weight.
+ */
+int rofi_scorer_fuzzy_evaluate_folded ( const char *pattern, glong plen, const char *str, const char *folded, glong slen, int case_sensitive );
 /*@}*/
 
 /**
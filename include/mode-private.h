@@ -31,7 +31,7 @@
 #include <gmodule.h>
 
 /** ABI version to check if loaded plugin is compatible. */
-#define ABI_VERSION    0x00000005
+#define ABI_VERSION    0x00000008
 
 /**
  * @param data Pointer to #Mode object.
@@ -74,7 +74,21 @@ typedef char * ( *_mode_get_completion )( const Mode *sw, unsigned int selected_
  *
  * @returns 1 when it matches, 0 if not.
  */
-typedef int ( *_mode_token_match )( const Mode *data, GRegex **tokens, unsigned int index );
+typedef int ( *_mode_token_match )( const Mode *data, rofi_int_matcher **tokens, unsigned int index );
+
+/**
+ * @param sw      The #Mode pointer
+ * @param tokens  List of (input) tokens to match.
+ * @param start   The first entry to match.
+ * @param stop    The entry after the last entry to match.
+ * @param matches Cleared bitmap with a bit for each entry in [start, stop). [out]
+ *
+ * Match a range of entries in one call, so the mode can loop over its own storage.
+ * Set bit (index - start) with helper_match_bitmap_set() for each entry that matches,
+ * this has to give the same result as #_mode_token_match on each entry.
+ * This is called from the filter worker threads.
+ */
+typedef void ( *_mode_token_match_range )( const Mode *sw, rofi_int_matcher **tokens, unsigned int start, unsigned int stop, guint32 *matches );
 
 /**
  * @param sw The #Mode pointer
@@ -133,6 +147,22 @@ typedef char* ( *_mode_preprocess_input )( Mode *sw, const char *input );
  */
 typedef char * ( *_mode_get_message )( const Mode *sw );
 
+/**
+ * @param sw The #Mode pointer
+ * @param selected_line The entry to query
+ * @param field Index of the string to get, 0 is the primary string of the entry.
+ * @param length Length of the returned string in characters, or -1 if not known. [out]
+ *
+ * Get one of the strings #_mode_token_match matches the entry against, without copying it.
+ * Field 0 is also the string the entry is sorted on.
+ * The fields have to cover every string #_mode_token_match looks at, the view builds its search index on them.
+ * Return an empty string, not NULL, for an empty field that is followed by more fields.
+ * This is called from the filter worker threads.
+ *
+ * @returns the string owned by the mode, or NULL when there is no such field.
+ */
+typedef const char * ( *_mode_get_match_string )( const Mode *sw, unsigned int selected_line, unsigned int field, glong *length );
+
 /**
  * Structure defining a switcher.
  * It consists of a name, callback and if enabled
@@ -169,6 +199,12 @@ struct rofi_mode
 
     _mode_get_message       _get_message;
 
+    /** Get the strings matched against, without copying. (optional) */
+    _mode_get_match_string  _get_match_string;
+
+    /** Token match a range of entries. (optional) */
+    _mode_token_match_range _token_match_range;
+
     /** Pointer to private data. */
     void                    *private_data;
 
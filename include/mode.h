@@ -27,6 +27,7 @@
 
 #ifndef ROFI_MODE_H
 #define ROFI_MODE_H
+#include "rofi-types.h"
 /**
  * @defgroup MODE Mode
  *
@@ -130,6 +131,19 @@ char * mode_get_display_value ( const Mode *mode, unsigned int selected_line, in
  */
 char * mode_get_completion ( const Mode *mode, unsigned int selected_line );
 
+/**
+ * @param mode The mode to query
+ * @param selected_line The entry to query
+ * @param field Index of the string to get, 0 is the string used for sorting.
+ * @param length Set to the length of the returned string in characters. [out]
+ *
+ * Get one of the strings the entry is matched against, without copying.
+ * Modes that do not implement this return NULL, use mode_get_completion() then.
+ *
+ * @returns the string owned by the mode, or NULL.
+ */
+const char * mode_get_match_string ( const Mode *mode, unsigned int selected_line, unsigned int field, glong *length );
+
 /**
  * @param mode The mode to query
  * @param menu_retv The menu return value.
@@ -151,7 +165,19 @@ ModeMode mode_result ( Mode *mode, int menu_retv, char **input, unsigned int sel
  *
  * @returns TRUE if matches
  */
-int mode_token_match ( const Mode *mode, GRegex **tokens, unsigned int selected_line );
+int mode_token_match ( const Mode *mode, rofi_int_matcher **tokens, unsigned int selected_line );
+
+/**
+ * @param mode    The mode to query
+ * @param tokens  The set of tokens to match against
+ * @param start   The first entry to match.
+ * @param stop    The entry after the last entry to match.
+ * @param matches Cleared bitmap with room for (stop - start) bits. [out]
+ *
+ * Match the entries in [start, stop) in one call. Bit (index - start) is set for each entry that matches,
+ * read it with helper_match_bitmap_get(). Modes that cannot match a range are matched one entry at a time.
+ */
+void mode_token_match_range ( const Mode *mode, rofi_int_matcher **tokens, unsigned int start, unsigned int stop, guint32 *matches );
 
 /**
  * @param mode The mode to query
@@ -0,0 +1,111 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef ROFI_PARALLEL_H
+#define ROFI_PARALLEL_H
+#include <glib.h>
+
+/**
+ * @defgroup PARALLEL Parallel
+ * @ingroup HELPERS
+ *
+ * Split a loop over a range of indexes over the worker threads.
+ *
+ * The range is cut in chunks, each worker starts on its own share of the chunks.
+ * A worker that runs out of work steals half of the remaining chunks of the busiest worker,
+ * so a few slow chunks do not leave the other threads idle.
+ * The chunk layout only depends on the size of the range and the number of workers, so callers
+ * can keep one result per chunk and merge them in chunk order afterwards.
+ *
+ * @{
+ */
+
+/**
+ * Description of how a range is cut in chunks.
+ */
+typedef struct
+{
+    /** Number of indexes in the range. */
+    unsigned int n;
+    /** Number of indexes in each chunk, the last one can be shorter. */
+    unsigned int chunk_size;
+    /** Number of chunks. */
+    unsigned int num_chunks;
+} RofiParallelRange;
+
+/**
+ * @param worker The worker running this chunk, 0 is the calling thread.
+ * @param chunk The index of the chunk.
+ * @param start The first index of the chunk.
+ * @param stop The index after the last index of the chunk.
+ * @param user_data The user data passed to rofi_parallel_for()
+ *
+ * Process one chunk. Chunks are run concurrently from different threads.
+ */
+typedef void ( *RofiParallelFunc )( unsigned int worker, unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data );
+
+/**
+ * @param workers The number of threads that may work on one loop, including the calling thread.
+ * @param error Location to store the error on failure.
+ *
+ * Setup the worker threads.
+ *
+ * @returns TRUE when successful.
+ */
+gboolean rofi_parallel_init ( unsigned int workers, GError **error );
+
+/**
+ * Stop the worker threads, waiting for running work to finish.
+ */
+void rofi_parallel_cleanup ( void );
+
+/**
+ * @returns the number of threads that work on one loop, including the calling thread.
+ */
+unsigned int rofi_parallel_num_workers ( void );
+
+/**
+ * @param range The range to initialize. [out]
+ * @param n The number of indexes.
+ * @param min_chunk_size The smallest chunk worth handing to another thread.
+ *
+ * Cut [0, n) in chunks for the current number of workers.
+ */
+void rofi_parallel_range_init ( RofiParallelRange *range, unsigned int n, unsigned int min_chunk_size );
+
+/**
+ * @param range The range to process.
+ * @param func The function called for each chunk.
+ * @param user_data Passed to func.
+ *
+ * Call func for every chunk in range and wait until all chunks are done.
+ * The calling thread works on the chunks too, so this also works when no other thread is available.
+ */
+void rofi_parallel_for ( const RofiParallelRange *range, RofiParallelFunc func, gpointer user_data );
+
+/**@}*/
+#endif // ROFI_PARALLEL_H
@@ -136,6 +136,8 @@ typedef struct
     unsigned int   sidebar_mode;
     /** Lazy filter limit. */
     unsigned int   lazy_filter_limit;
+    /** Filter on likely next characters while idle. */
+    unsigned int   speculate;
     /** Auto select. */
     unsigned int   auto_select;
     /** Hosts file parsing */
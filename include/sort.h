@@ -0,0 +1,118 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef ROFI_SORT_H
+#define ROFI_SORT_H
+#include <glib.h>
+
+/**
+ * @defgroup SORT Sort
+ * @ingroup HELPERS
+ *
+ * Sort lists of row indexes on their distance.
+ *
+ * Rows are ordered on ascending distance, rows with the same distance keep the order
+ * of their index, so e.g. history entries at the top of a mode stay first.
+ * This is a total order, so the result does not depend on the order the rows were passed in.
+ *
+ * @{
+ */
+
+/**
+ * @param rows The row indexes to sort.
+ * @param n The number of rows.
+ * @param distance The distance of each row, indexed on row index.
+ *
+ * Sort the rows. Long lists are radix sorted on (distance, row index), split over the workers.
+ */
+void rofi_sort_rows ( unsigned int *rows, unsigned int n, const int *distance );
+
+/**
+ * @param rows The row indexes to sort.
+ * @param n The number of rows.
+ * @param distance The distance of each row, indexed on row index.
+ *
+ * Like rofi_sort_rows(), but only in the calling thread. For use from within a worker.
+ */
+void rofi_sort_rows_serial ( unsigned int *rows, unsigned int n, const int *distance );
+
+/**
+ * @param dst Where to store the result, room for the total length of the runs.
+ * @param src The rows holding the runs.
+ * @param run_start The offset of each run in src.
+ * @param run_length The number of rows in each run.
+ * @param num_runs The number of runs.
+ * @param distance The distance of each row, indexed on row index.
+ *
+ * Merge sorted runs of rows into one sorted list.
+ * The result is cut in parts that the workers merge at the same time.
+ */
+void rofi_sort_merge ( unsigned int *dst, const unsigned int *src, const unsigned int *run_start, const unsigned int *run_length, unsigned int num_runs, const int *distance );
+
+/**
+ * @param rows The row indexes to sort.
+ * @param n The number of rows.
+ * @param k The number of rows to put in order.
+ * @param distance The distance of each row, indexed on row index.
+ *
+ * Move the k rows that come first to the front of rows, in order.
+ * The remaining rows all come after these, but are left unsorted.
+ * Calling this again on the remainder continues the sort, at about the cost of a
+ * linear pass instead of a full sort each time.
+ */
+void rofi_sort_partial ( unsigned int *rows, unsigned int n, unsigned int k, const int *distance );
+
+/**
+ * @param rows The row indexes to sort.
+ * @param n The number of rows.
+ * @param k The number of rows to put in order.
+ * @param distance The distance of each row, indexed on row index.
+ *
+ * Like rofi_sort_partial(), but only in the calling thread. For use from within a worker.
+ */
+void rofi_sort_partial_serial ( unsigned int *rows, unsigned int n, unsigned int k, const int *distance );
+
+/**
+ * @param rows The n rows of a list, of which the first sorted are in order, followed by m appended rows,
+ *             of which the first m_sorted are in order.
+ * @param n The number of rows in the list.
+ * @param sorted The number of rows at the start of the list that are in order and come before the rest.
+ * @param m The number of appended rows.
+ * @param m_sorted The number of appended rows that are in order and come before the other appended rows.
+ * @param distance The distance of each row, indexed on row index.
+ *
+ * Merge the appended rows into the sorted part of the list, as rofi_sort_partial() on all n + m rows would
+ * leave it. This only touches the sorted parts and moves a few unsorted rows out of the way, so the cost
+ * does not grow with the length of the list.
+ *
+ * @returns the number of rows at the start of the n + m rows that are in order and come before the rest.
+ */
+unsigned int rofi_sort_append ( unsigned int *rows, unsigned int n, unsigned int sorted, unsigned int m, unsigned int m_sorted, const int *distance );
+
+/**@}*/
+#endif // ROFI_SORT_H
@@ -0,0 +1,102 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef ROFI_TRIGRAM_H
+#define ROFI_TRIGRAM_H
+#include <glib.h>
+
+/**
+ * @defgroup TRIGRAM Trigram
+ * @ingroup HELPERS
+ *
+ * Index of the trigrams (three byte sequences) in the strings of each row.
+ *
+ * A row can only contain a search string if it contains all trigrams of that string.
+ * Intersecting the rows of these trigrams gives a (usually small) set of candidate rows,
+ * only those have to be checked with the real matcher.
+ *
+ * ASCII letters are folded to lower case and all other bytes >= 0x80 are seen as one byte,
+ * so the index works for both case sensitive and insensitive matching.
+ *
+ * @{
+ */
+
+/**
+ * The index.
+ */
+typedef struct _RofiTrigramIndex   RofiTrigramIndex;
+
+/**
+ * @param row The row.
+ * @param field The string of the row to get, starting at 0.
+ * @param user_data The user data passed to rofi_trigram_index_new()
+ *
+ * Get a string of a row. This is called from the worker threads.
+ * Rows without a string for field 0 are not indexed, they are a candidate for every input.
+ *
+ * @returns the string, NULL when the row has no more fields.
+ */
+typedef const char * ( *RofiTrigramTextFunc )( unsigned int row, unsigned int field, gpointer user_data );
+
+/**
+ * @param num_rows The number of rows.
+ * @param func Function to get the strings of a row.
+ * @param user_data Passed to func.
+ * @param cancel Set to non-zero (from any thread) to stop building, NULL if not used.
+ *
+ * Build the index, spread over the workers.
+ *
+ * @returns a new index, free with rofi_trigram_index_free(), or NULL when cancelled or the strings are too long to index.
+ */
+RofiTrigramIndex * rofi_trigram_index_new ( unsigned int num_rows, RofiTrigramTextFunc func, gpointer user_data, const gint *cancel );
+
+/**
+ * @param index The index to free.
+ *
+ * Free the index.
+ */
+void rofi_trigram_index_free ( RofiTrigramIndex *index );
+
+/**
+ * @param index The index.
+ * @param pattern The (preprocessed) input.
+ * @param method The #MatchingMethod used.
+ * @param tokenize If the input is split in tokens on spaces.
+ * @param case_sensitive If matching is case sensitive.
+ * @param candidates The rows that can match, in ascending order. Free with g_free(). [out]
+ * @param num_candidates The number of candidate rows. [out]
+ *
+ * Find the rows that can match the input. Only plain and glob matching can be narrowed down,
+ * and only on the parts of at least three characters.
+ *
+ * @returns FALSE if the index cannot narrow down the rows for this input.
+ */
+gboolean rofi_trigram_index_query ( const RofiTrigramIndex *index, const char *pattern, int method, gboolean tokenize, gboolean case_sensitive, unsigned int **candidates, unsigned int *num_candidates );
+
+/**@}*/
+#endif // ROFI_TRIGRAM_H
@@ -35,6 +35,8 @@
 #include "keyb.h"
 #include "x11-helper.h"
 #include "theme.h"
+#include "trigram.h"
+#include "fold.h"
 
 /**
  * @ingroup ViewHandle
@@ -78,9 +80,13 @@ struct RofiViewState
     unsigned int     *line_map;
     /** number of (unfiltered) elements to show. */
     unsigned int     num_lines;
+    /** Number of rows #line_map and #distance have room for. */
+    unsigned int     line_map_size;
 
     /** number of (filtered) elements to show. */
     unsigned int     filtered_lines;
+    /** number of elements at the start of line_map that are sorted. */
+    unsigned int     sorted_lines;
 
     /** Previously called key action. */
     KeyBindingAction prev_action;
@@ -123,7 +129,27 @@ struct RofiViewState
     int              y;
 
     /** Regexs used for matching */
-    GRegex           **tokens;
+    rofi_int_matcher **tokens;
+
+    /** Input #line_map was filtered on, NULL if the result cannot be narrowed. */
+    char             *last_filter;
+    /** Matching method used to filter on #last_filter. */
+    int              last_filter_method;
+    /** Case sensitivity used to filter on #last_filter. */
+    unsigned int     last_filter_case;
+    /** Sorting used to filter on #last_filter. */
+    unsigned int     last_filter_sort;
+
+    /** Trigram index over the rows, NULL if not built (yet). */
+    RofiTrigramIndex *trigram;
+    /** Case folded primary strings of the rows, NULL if not built (yet). */
+    RofiFoldCorpus   *folded;
+    /** The rows did not change since the user last typed, so they are worth indexing. */
+    int              rows_stable;
+    /** Recent filter results, most recently used first. */
+    GList            *result_cache;
+    /** Highlighted parts of the shown rows, by row. */
+    GHashTable       *match_spans;
 };
 /** @} */
 #endif
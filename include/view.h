@@ -91,7 +91,7 @@ MenuReturn rofi_view_get_return_value ( const RofiViewState *state );
  *
  * @return the next position.
  */
-unsigned int rofi_view_get_next_position ( const RofiViewState *state );
+unsigned int rofi_view_get_next_position ( RofiViewState *state );
 /**
  * @param state the Menu handle
  * @param event the event to handle
@@ -218,6 +218,21 @@ void rofi_view_hide ( void );
  */
 void rofi_view_reload ( void  );
 
+/**
+ * Indicate the mode of the current view added rows after its existing rows, without changing those.
+ * Only the new rows are filtered and added to the shown result, instead of filtering all rows again.
+ *
+ * Like rofi_view_reload(), this happens 'lazy' and multiple calls might be handled at once.
+ */
+void rofi_view_reload_append ( void );
+
+/**
+ * Stop the filter that might be running in the background on the current view.
+ * Call this before changing data of the mode that the filter could be reading.
+ * The view filters again on the next reload.
+ */
+void rofi_view_cancel_filter ( void );
+
 /**
  * @param state The handle to the view
  * @param mode The new mode to display
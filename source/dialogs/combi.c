@@ -30,6 +30,7 @@
 #include <config.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <rofi.h>
 #include "settings.h"
 #include "helper.h"
@@ -39,6 +40,9 @@
 #include "mode-private.h"
 #include <theme.h>
 
+/** Number of entries matched per call on a stack bitmap, the same block size the filter uses. */
+#define COMBI_MATCH_BLOCK    256
+
 /**
  * Combi Mode
  */
@@ -180,7 +184,7 @@ static ModeMode combi_mode_result ( Mode *sw, int mretv, char **input, unsigned
     }
     return MODE_EXIT;
 }
-static int combi_mode_match ( const Mode *sw, GRegex **tokens, unsigned int index )
+static int combi_mode_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
 {
     CombiModePrivateData *pd = mode_get_private_data ( sw );
     for ( unsigned i = 0; i < pd->num_switchers; i++ ) {
@@ -193,6 +197,35 @@ static int combi_mode_match ( const Mode *sw, GRegex **tokens, unsigned int inde
     }
     return 0;
 }
+static void combi_mode_match_range ( const Mode *sw, rofi_int_matcher **tokens, unsigned int start, unsigned int stop, guint32 *matches )
+{
+    CombiModePrivateData *pd = mode_get_private_data ( sw );
+    for ( unsigned i = 0; i < pd->num_switchers; i++ ) {
+        unsigned int sub_start = MAX ( start, pd->starts[i] );
+        unsigned int sub_stop  = MIN ( stop, pd->starts[i] + pd->lengths[i] );
+        if ( pd->switchers[i].disable || sub_start >= sub_stop ) {
+            continue;
+        }
+        unsigned int offset = sub_start - start;
+        if ( ( offset % 32 ) == 0 ) {
+            // The mode's bits start on a word boundary, let it write into matches directly.
+            mode_token_match_range ( pd->switchers[i].mode, tokens, sub_start - pd->starts[i], sub_stop - pd->starts[i], &matches[offset / 32] );
+            continue;
+        }
+        // Otherwise match it in blocks on the stack and shift the bits into place.
+        for ( unsigned int b = sub_start; b < sub_stop; b += COMBI_MATCH_BLOCK ) {
+            unsigned int n = MIN ( sub_stop - b, COMBI_MATCH_BLOCK );
+            guint32      sub[COMBI_MATCH_BLOCK / 32];
+            memset ( sub, 0, sizeof ( sub ) );
+            mode_token_match_range ( pd->switchers[i].mode, tokens, b - pd->starts[i], b - pd->starts[i] + n, sub );
+            for ( unsigned int j = 0; j < n; j++ ) {
+                if ( helper_match_bitmap_get ( sub, j ) ) {
+                    helper_match_bitmap_set ( matches, b - start + j );
+                }
+            }
+        }
+    }
+}
 static char * combi_mgrv ( const Mode *sw, unsigned int selected_line, int *state, GList **attr_list, int get_entry )
 {
     CombiModePrivateData *pd = mode_get_private_data ( sw );
@@ -247,6 +280,18 @@ static char * combi_get_completion ( const Mode *sw, unsigned int index )
     return NULL;
 }
 
+static const char * combi_get_match_string ( const Mode *sw, unsigned int index, unsigned int field, glong *length )
+{
+    CombiModePrivateData *pd = mode_get_private_data ( sw );
+    for ( unsigned i = 0; i < pd->num_switchers; i++ ) {
+        if ( index >= pd->starts[i] && index < ( pd->starts[i] + pd->lengths[i] ) ) {
+            // The '!mode ' prefix of the completion is never matched against, so it is not part of this.
+            return mode_get_match_string ( pd->switchers[i].mode, index - pd->starts[i], field, length );
+        }
+    }
+    return NULL;
+}
+
 static char * combi_preprocess_input ( Mode *sw, const char *input )
 {
     CombiModePrivateData *pd = mode_get_private_data ( sw );
@@ -283,9 +328,11 @@ Mode combi_mode =
     ._result            = combi_mode_result,
     ._destroy           = combi_mode_destroy,
     ._token_match       = combi_mode_match,
+    ._token_match_range = combi_mode_match_range,
     ._get_completion    = combi_get_completion,
     ._get_display_value = combi_mgrv,
     ._preprocess_input  = combi_preprocess_input,
+    ._get_match_string  = combi_get_match_string,
     .private_data       = NULL,
     .free               = NULL
 };
@@ -40,6 +40,7 @@
 #include <gio/gunixinputstream.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include "rofi.h"
 #include "settings.h"
@@ -48,6 +49,14 @@
 #include "helper.h"
 #include "xrmoptions.h"
 #include "view.h"
+#include "parallel.h"
+
+/** Size of the blocks the input is read in. */
+#define DMENU_BLOCK_SIZE          ( 256 * 1024 )
+/** Size of the pieces a mapped input file is cut in to find the separators. */
+#define DMENU_MAP_PIECE_SIZE      ( 1024 * 1024 )
+/** Fewest entries of a mapped input file worth handing to another thread. */
+#define DMENU_MAP_MIN_CHUNK_SIZE    4096
 
 struct range_pair
 {
@@ -87,6 +96,8 @@ typedef struct
     unsigned int      do_markup;
     // List with entries.
     char              **cmd_list;
+    // Length in characters of each entry.
+    glong             *cmd_list_lengths;
     unsigned int      cmd_list_real_length;
     unsigned int      cmd_list_length;
     unsigned int      only_selected;
@@ -99,7 +110,22 @@ typedef struct
     GCancellable      *cancel;
     gulong            cancel_source;
     GInputStream      *input_stream;
-    GDataInputStream  *data_input_stream;
+
+    // The entries point into these blocks, split in place.
+    // Full blocks, and copies of entries that were not valid UTF-8.
+    GPtrArray         *blocks;
+    // Block being read into.
+    char              *block;
+    // Size of block, one more byte is allocated for the last '\0'.
+    gsize             block_size;
+    // Number of bytes read into block.
+    gsize             block_used;
+    // Start of the entry in block that is not complete yet.
+    gsize             block_start;
+
+    // Private mapping of the -input file, the entries point into it. NULL when reading a stream.
+    char              *mapped;
+    gsize             mapped_size;
 } DmenuModePrivateData;
 
 static void async_close_callback ( GObject *source_object, GAsyncResult *res, G_GNUC_UNUSED gpointer user_data )
@@ -108,58 +134,158 @@ static void async_close_callback ( GObject *source_object, GAsyncResult *res, G_
     g_debug ( "Closing data stream." );
 }
 
-static void read_add ( DmenuModePrivateData * pd, char *data, gsize len )
+/**
+ * @param pd    The dmenu mode data.
+ * @param data  The entry, '\0' terminated and owned by the blocks.
+ * @param len   The length of data in bytes.
+ * @param valid TRUE if data is known to be valid UTF-8.
+ *
+ * Add an entry to the list, without copying it if it is valid UTF-8.
+ */
+static void read_add ( DmenuModePrivateData * pd, char *data, gsize len, gboolean valid )
 {
     if ( ( pd->cmd_list_length + 2 ) > pd->cmd_list_real_length ) {
+        // The filter reads the list from another thread, stop it before moving the list.
+        rofi_view_cancel_filter ();
         pd->cmd_list_real_length = MAX ( pd->cmd_list_real_length * 2, 512 );
         pd->cmd_list             = g_realloc ( pd->cmd_list, ( pd->cmd_list_real_length ) * sizeof ( char* ) );
+        pd->cmd_list_lengths     = g_realloc ( pd->cmd_list_lengths, ( pd->cmd_list_real_length ) * sizeof ( glong ) );
+    }
+    if ( !valid && !g_utf8_validate ( data, len, NULL ) ) {
+        data = rofi_force_utf8 ( data, len );
+        g_ptr_array_add ( pd->blocks, data );
     }
-    char *utfstr = rofi_force_utf8 ( data, len );
-    pd->cmd_list[pd->cmd_list_length]     = utfstr;
-    pd->cmd_list[pd->cmd_list_length + 1] = NULL;
+    pd->cmd_list[pd->cmd_list_length]         = data;
+    pd->cmd_list_lengths[pd->cmd_list_length] = g_utf8_strlen ( data, -1 );
+    pd->cmd_list[pd->cmd_list_length + 1]     = NULL;
 
     pd->cmd_list_length++;
 }
+
+/**
+ * @param pd The dmenu mode data.
+ *
+ * Make sure there is room to read into the current block.
+ * A full block is kept as long as entries point into it, the incomplete entry at its end is moved to a new block.
+ */
+static void read_block_reserve ( DmenuModePrivateData *pd )
+{
+    if ( pd->block != NULL && pd->block_used < pd->block_size ) {
+        return;
+    }
+    if ( pd->block != NULL && pd->block_start == 0 ) {
+        // One entry fills the whole block, nothing points into it yet.
+        pd->block_size *= 2;
+        pd->block       = g_realloc ( pd->block, pd->block_size + 1 );
+        return;
+    }
+    gsize partial = pd->block_used - pd->block_start;
+    gsize size    = MAX ( DMENU_BLOCK_SIZE, 2 * partial );
+    char  *block  = g_malloc ( size + 1 );
+    if ( pd->block != NULL ) {
+        memcpy ( block, pd->block + pd->block_start, partial );
+        g_ptr_array_add ( pd->blocks, pd->block );
+    }
+    pd->block       = block;
+    pd->block_size  = size;
+    pd->block_used  = partial;
+    pd->block_start = 0;
+}
+
+/**
+ * @param pd  The dmenu mode data.
+ * @param len The number of bytes just read into the block.
+ *
+ * Split the complete entries in the block in place, replacing the separators by '\0'.
+ */
+static void read_block_split ( DmenuModePrivateData *pd, gsize len )
+{
+    char *scan = pd->block + pd->block_used;
+    char *end  = scan + len;
+    pd->block_used += len;
+    // The complete entries end at the last separator.
+    char *last = end;
+    while ( last > scan && last[-1] != pd->separator ) {
+        last--;
+    }
+    if ( last == scan ) {
+        return;
+    }
+    // An ASCII separator is never part of a multi-byte character, so all complete entries can be validated at once.
+    char     *line  = pd->block + pd->block_start;
+    gboolean valid = pd->separator != '\0' && !( pd->separator & 0x80 ) && g_utf8_validate ( line, last - 1 - line, NULL );
+    for ( char *s = memchr ( scan, pd->separator, last - scan ); s != NULL; s = memchr ( s, pd->separator, last - s ) ) {
+        *s = '\0';
+        read_add ( pd, line, s - line, valid );
+        line = ++s;
+    }
+    pd->block_start = line - pd->block;
+}
+
+/**
+ * @param pd The dmenu mode data.
+ *
+ * Add the last entry when the input does not end with a separator.
+ */
+static void read_block_finish ( DmenuModePrivateData *pd )
+{
+    if ( pd->block != NULL && pd->block_start < pd->block_used ) {
+        pd->block[pd->block_used] = '\0';
+        read_add ( pd, pd->block + pd->block_start, pd->block_used - pd->block_start, FALSE );
+        pd->block_start = pd->block_used;
+    }
+}
+
+/**
+ * @param pd The dmenu mode data.
+ *
+ * Read the next block of input, blocking.
+ *
+ * @returns FALSE at the end of the input or on error.
+ */
+static gboolean read_block ( DmenuModePrivateData *pd )
+{
+    read_block_reserve ( pd );
+    gssize len = g_input_stream_read ( pd->input_stream, pd->block + pd->block_used, pd->block_size - pd->block_used, pd->cancel, NULL );
+    if ( len <= 0 ) {
+        if ( len == 0 ) {
+            read_block_finish ( pd );
+        }
+        return FALSE;
+    }
+    read_block_split ( pd, len );
+    return TRUE;
+}
+
+static void async_read_callback ( GObject *source_object, GAsyncResult *res, gpointer user_data );
+static void read_block_async ( DmenuModePrivateData *pd )
+{
+    read_block_reserve ( pd );
+    g_input_stream_read_async ( pd->input_stream, pd->block + pd->block_used, pd->block_size - pd->block_used, G_PRIORITY_LOW, pd->cancel,
+                                async_read_callback, pd );
+}
+
 static void async_read_callback ( GObject *source_object, GAsyncResult *res, gpointer user_data )
 {
-    GDataInputStream     *stream = (GDataInputStream *) source_object;
+    GInputStream         *stream = G_INPUT_STREAM ( source_object );
     DmenuModePrivateData *pd     = (DmenuModePrivateData *) user_data;
-    gsize                len;
-    char                 *data = g_data_input_stream_read_upto_finish ( stream, res, &len, NULL );
-    if ( data != NULL ) {
-        // Absorb separator, already in buffer so should not block.
-        g_data_input_stream_read_byte ( stream, NULL, NULL );
-        read_add ( pd, data, len );
-        g_free ( data );
-        rofi_view_reload ();
-
-        g_data_input_stream_read_upto_async ( pd->data_input_stream, &( pd->separator ), 1, G_PRIORITY_LOW, pd->cancel,
-                                              async_read_callback, pd );
+    gssize               len     = g_input_stream_read_finish ( stream, res, NULL );
+    if ( len > 0 ) {
+        read_block_split ( pd, len );
+        rofi_view_reload_append ();
+        read_block_async ( pd );
         return;
     }
-    else {
-        GError *error = NULL;
-        // Absorb separator, already in buffer so should not block.
-        // If error == NULL end of stream..
-        g_data_input_stream_read_byte ( stream, NULL, &error );
-        if (  error == NULL ) {
-            // Add empty line.
-            read_add ( pd, "", 0 );
-            rofi_view_reload ();
-
-            g_data_input_stream_read_upto_async ( pd->data_input_stream, &( pd->separator ), 1, G_PRIORITY_LOW, pd->cancel,
-                                                  async_read_callback, pd );
-            return;
-        }
-        else {
-            g_error_free ( error );
-        }
+    else if ( len == 0 ) {
+        // End of stream.
+        read_block_finish ( pd );
+        rofi_view_reload_append ();
     }
     if ( !g_cancellable_is_cancelled ( pd->cancel ) ) {
         // Hack, don't use get active.
         g_debug ( "Clearing overlay" );
         rofi_view_set_overlay ( rofi_view_get_active (), NULL );
-        g_input_stream_close_async ( G_INPUT_STREAM ( stream ), G_PRIORITY_LOW, pd->cancel, async_close_callback, pd );
+        g_input_stream_close_async ( stream, G_PRIORITY_LOW, pd->cancel, async_close_callback, pd );
     }
 }
 
@@ -168,38 +294,161 @@ static void async_read_cancel ( G_GNUC_UNUSED GCancellable *cancel, G_GNUC_UNUSE
     g_debug ( "Cancelled the async read." );
 }
 
-static int get_dmenu_async ( DmenuModePrivateData *pd, int sync_pre_read )
+static int get_dmenu_async ( DmenuModePrivateData *pd, unsigned int sync_pre_read )
 {
-    while ( sync_pre_read-- ) {
-        gsize len   = 0;
-        char  *data = g_data_input_stream_read_upto ( pd->data_input_stream, &( pd->separator ), 1, &len, NULL, NULL );
-        if ( data == NULL ) {
+    while ( pd->cmd_list_length < sync_pre_read ) {
+        if ( !read_block ( pd ) ) {
             g_input_stream_close_async ( G_INPUT_STREAM ( pd->input_stream ), G_PRIORITY_LOW, pd->cancel, async_close_callback, pd );
             return FALSE;
         }
-        g_data_input_stream_read_byte ( pd->data_input_stream, NULL, NULL );
-        read_add ( pd, data, len );
-        g_free ( data );
     }
-    g_data_input_stream_read_upto_async ( pd->data_input_stream, &( pd->separator ), 1, G_PRIORITY_LOW, pd->cancel,
-                                          async_read_callback, pd );
+    read_block_async ( pd );
     return TRUE;
 }
 static void get_dmenu_sync ( DmenuModePrivateData *pd )
 {
-    while  ( TRUE ) {
-        gsize len   = 0;
-        char  *data = g_data_input_stream_read_upto ( pd->data_input_stream, &( pd->separator ), 1, &len, NULL, NULL );
-        if ( data == NULL ) {
-            break;
-        }
-        g_data_input_stream_read_byte ( pd->data_input_stream, NULL, NULL );
-        read_add ( pd, data, len );
-        g_free ( data );
+    while ( read_block ( pd ) ) {
+        ;
     }
     g_input_stream_close_async ( G_INPUT_STREAM ( pd->input_stream ), G_PRIORITY_LOW, pd->cancel, async_close_callback, pd );
 }
 
+/**
+ * State shared by the workers indexing a mapped input file.
+ */
+typedef struct
+{
+    DmenuModePrivateData *pd;
+    /** Number of separators in each chunk of pieces, then the number of separators before it. */
+    unsigned int         *chunk_separators;
+    /** Number of separators in the file. */
+    unsigned int         num_separators;
+    /** The mapping has room for a '\0' after the end of the file, the rest of the last page. */
+    gboolean             tail_room;
+} DmenuMapIndex;
+
+static void dmenu_map_count ( G_GNUC_UNUSED unsigned int worker, unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data )
+{
+    DmenuMapIndex              *index = (DmenuMapIndex *) user_data;
+    const DmenuModePrivateData *pd    = index->pd;
+    const char                 *p     = pd->mapped + (gsize) start * DMENU_MAP_PIECE_SIZE;
+    const char                 *end   = pd->mapped + MIN ( pd->mapped_size, (gsize) stop * DMENU_MAP_PIECE_SIZE );
+    unsigned int               count  = 0;
+    for (; ( p = memchr ( p, pd->separator, end - p ) ) != NULL; p++ ) {
+        count++;
+    }
+    index->chunk_separators[chunk] = count;
+}
+
+/**
+ * Each entry starts after a separator, store those starts.
+ */
+static void dmenu_map_fill ( G_GNUC_UNUSED unsigned int worker, unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data )
+{
+    DmenuMapIndex        *index = (DmenuMapIndex *) user_data;
+    DmenuModePrivateData *pd    = index->pd;
+    char                 *p     = pd->mapped + (gsize) start * DMENU_MAP_PIECE_SIZE;
+    char                 *end   = pd->mapped + MIN ( pd->mapped_size, (gsize) stop * DMENU_MAP_PIECE_SIZE );
+    unsigned int         entry  = index->chunk_separators[chunk];
+    for (; ( p = memchr ( p, pd->separator, end - p ) ) != NULL; p++ ) {
+        pd->cmd_list[++entry] = p + 1;
+    }
+}
+
+/**
+ * @returns the end of an entry in the mapped file, its separator or the end of the file.
+ */
+static inline char *dmenu_map_entry_end ( const DmenuMapIndex *index, unsigned int entry )
+{
+    const DmenuModePrivateData *pd = index->pd;
+    return ( entry < index->num_separators ) ? pd->cmd_list[entry + 1] - 1 : pd->mapped + pd->mapped_size;
+}
+
+/**
+ * Terminate the entries in place and check they are valid UTF-8.
+ * Entries that need a copy get length -1, they are fixed up afterwards in the calling thread.
+ */
+static void dmenu_map_check ( G_GNUC_UNUSED unsigned int worker, G_GNUC_UNUSED unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data )
+{
+    DmenuMapIndex        *index = (DmenuMapIndex *) user_data;
+    DmenuModePrivateData *pd    = index->pd;
+    for ( unsigned int i = start; i < stop; i++ ) {
+        char     *s         = pd->cmd_list[i];
+        char     *e         = dmenu_map_entry_end ( index, i );
+        gboolean terminated = TRUE;
+        if ( i < index->num_separators ) {
+            *e = '\0';
+        }
+        else {
+            // The last entry without separator, the mapping is zero filled after the end of the file.
+            terminated = index->tail_room;
+        }
+        pd->cmd_list_lengths[i] = ( terminated && g_utf8_validate ( s, e - s, NULL ) ) ? g_utf8_strlen ( s, e - s ) : -1;
+    }
+}
+
+/**
+ * @param pd The dmenu mode data.
+ * @param fd The -input file.
+ *
+ * Map the input file and index its entries in place, with the separators replaced by '\0'.
+ * The file is split over the workers to find the separators and again to check the entries.
+ *
+ * @returns TRUE if the entries are read, FALSE if the file has to be read as a stream.
+ */
+static gboolean dmenu_map_input ( DmenuModePrivateData *pd, int fd )
+{
+    struct stat st;
+    if ( fstat ( fd, &st ) != 0 || !S_ISREG ( st.st_mode ) || st.st_size <= 0 ) {
+        return FALSE;
+    }
+    // Private, so writing the '\0' does not change the file.
+    void *mapped = mmap ( NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+    if ( mapped == MAP_FAILED ) {
+        g_debug ( "Failed to map input file: %s", g_strerror ( errno ) );
+        return FALSE;
+    }
+    pd->mapped      = mapped;
+    pd->mapped_size = st.st_size;
+
+    RofiParallelRange range;
+    rofi_parallel_range_init ( &range, ( pd->mapped_size + DMENU_MAP_PIECE_SIZE - 1 ) / DMENU_MAP_PIECE_SIZE, 1 );
+    DmenuMapIndex     index = {
+        .pd               = pd,
+        .chunk_separators = g_malloc0_n ( range.num_chunks + 1, sizeof ( unsigned int ) ),
+        .tail_room        = ( pd->mapped_size % sysconf ( _SC_PAGESIZE ) ) != 0,
+    };
+    rofi_parallel_for ( &range, dmenu_map_count, &index );
+    for ( unsigned int i = 0; i < range.num_chunks; i++ ) {
+        unsigned int count = index.chunk_separators[i];
+        index.chunk_separators[i] = index.num_separators;
+        index.num_separators     += count;
+    }
+    // Like a stream, a separator at the end of the file does not start another entry.
+    pd->cmd_list_length      = index.num_separators + ( pd->mapped[pd->mapped_size - 1] != pd->separator );
+    pd->cmd_list_real_length = pd->cmd_list_length + 1;
+    pd->cmd_list             = g_malloc_n ( pd->cmd_list_real_length, sizeof ( char* ) );
+    pd->cmd_list_lengths     = g_malloc_n ( pd->cmd_list_real_length, sizeof ( glong ) );
+    pd->cmd_list[0]          = pd->mapped;
+    rofi_parallel_for ( &range, dmenu_map_fill, &index );
+
+    rofi_parallel_range_init ( &range, pd->cmd_list_length, DMENU_MAP_MIN_CHUNK_SIZE );
+    rofi_parallel_for ( &range, dmenu_map_check, &index );
+    for ( unsigned int i = 0; i < pd->cmd_list_length; i++ ) {
+        if ( pd->cmd_list_lengths[i] < 0 ) {
+            char  *s   = pd->cmd_list[i];
+            gsize len  = dmenu_map_entry_end ( &index, i ) - s;
+            char  *fix = g_utf8_validate ( s, len, NULL ) ? g_strndup ( s, len ) : rofi_force_utf8 ( s, len );
+            g_ptr_array_add ( pd->blocks, fix );
+            pd->cmd_list[i]         = fix;
+            pd->cmd_list_lengths[i] = g_utf8_strlen ( fix, -1 );
+        }
+    }
+    pd->cmd_list[pd->cmd_list_length] = NULL;
+    g_free ( index.chunk_separators );
+    return TRUE;
+}
+
 static unsigned int dmenu_mode_get_num_entries ( const Mode *sw )
 {
     const DmenuModePrivateData *rmpd = (const DmenuModePrivateData *) mode_get_private_data ( sw );
@@ -366,18 +615,21 @@ static void dmenu_mode_free ( Mode *sw )
             g_cancellable_disconnect ( pd->cancel, pd->cancel_source );
             if ( pd->input_stream ) {
                 // Should close the stream if not yet done.
-                g_object_unref ( pd->data_input_stream );
                 g_object_unref ( pd->input_stream );
             }
             g_object_unref ( pd->cancel );
         }
 
-        for ( size_t i = 0; i < pd->cmd_list_length; i++ ) {
-            if ( pd->cmd_list[i] ) {
-                free ( pd->cmd_list[i] );
-            }
+        // The entries point into the blocks.
+        if ( pd->blocks != NULL ) {
+            g_ptr_array_free ( pd->blocks, TRUE );
+        }
+        g_free ( pd->block );
+        if ( pd->mapped != NULL ) {
+            munmap ( pd->mapped, pd->mapped_size );
         }
         g_free ( pd->cmd_list );
+        g_free ( pd->cmd_list_lengths );
         g_free ( pd->urgent_list );
         g_free ( pd->active_list );
         g_free ( pd->selected_list );
@@ -437,6 +689,7 @@ static int dmenu_mode_init ( Mode *sw )
     if ( find_arg ( "-i" ) >= 0 ) {
         config.case_sensitive = FALSE;
     }
+    pd->blocks = g_ptr_array_new_with_free_func ( g_free );
     int fd = STDIN_FILENO;
     str = NULL;
     if ( find_arg_str ( "-input", &str ) ) {
@@ -450,11 +703,16 @@ static int dmenu_mode_init ( Mode *sw )
             return TRUE;
         }
         g_free ( estr );
+        if ( dmenu_map_input ( pd, fd ) ) {
+            // The mapping stays valid after closing the file.
+            close ( fd );
+        }
+    }
+    if ( pd->mapped == NULL ) {
+        pd->cancel        = g_cancellable_new ();
+        pd->cancel_source = g_cancellable_connect ( pd->cancel, G_CALLBACK ( async_read_cancel ), pd, NULL );
+        pd->input_stream  = g_unix_input_stream_new ( fd, fd != STDIN_FILENO );
     }
-    pd->cancel            = g_cancellable_new ();
-    pd->cancel_source     = g_cancellable_connect ( pd->cancel, G_CALLBACK ( async_read_cancel ), pd, NULL );
-    pd->input_stream      = g_unix_input_stream_new ( fd, fd != STDIN_FILENO );
-    pd->data_input_stream = g_data_input_stream_new ( pd->input_stream );
 
     gchar *columns = NULL;
     if ( find_arg_str ( "-display-columns", &columns ) ) {
@@ -465,11 +723,25 @@ static int dmenu_mode_init ( Mode *sw )
     return TRUE;
 }
 
-static int dmenu_token_match ( const Mode *sw, GRegex **tokens, unsigned int index )
+static int dmenu_token_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
 {
     DmenuModePrivateData *rmpd = (DmenuModePrivateData *) mode_get_private_data ( sw );
     return helper_token_match ( tokens, rmpd->cmd_list[index] );
 }
+static void dmenu_token_match_range ( const Mode *sw, rofi_int_matcher **tokens, unsigned int start, unsigned int stop, guint32 *matches )
+{
+    DmenuModePrivateData *rmpd = (DmenuModePrivateData *) mode_get_private_data ( sw );
+    helper_token_match_range ( tokens, rmpd->cmd_list, start, stop, matches );
+}
+static const char *dmenu_get_match_string ( const Mode *sw, unsigned int index, unsigned int field, glong *length )
+{
+    DmenuModePrivateData *rmpd = (DmenuModePrivateData *) mode_get_private_data ( sw );
+    if ( field != 0 ) {
+        return NULL;
+    }
+    *length = rmpd->cmd_list_lengths[index];
+    return rmpd->cmd_list[index];
+}
 static char *dmenu_get_message ( const Mode *sw )
 {
     DmenuModePrivateData *pd = (DmenuModePrivateData *) mode_get_private_data ( sw );
@@ -490,10 +762,12 @@ Mode dmenu_mode =
     ._result            = NULL,
     ._destroy           = dmenu_mode_free,
     ._token_match       = dmenu_token_match,
+    ._token_match_range = dmenu_token_match_range,
     ._get_display_value = get_display_data,
     ._get_completion    = NULL,
     ._preprocess_input  = NULL,
     ._get_message       = dmenu_get_message,
+    ._get_match_string  = dmenu_get_match_string,
     .private_data       = NULL,
     .free               = NULL,
     .display_name       = "dmenu:"
@@ -642,7 +916,11 @@ int dmenu_switcher_dialog ( void )
          find_arg ( "-selected-row" ) >= 0 ) {
         async = FALSE;
     }
-    if ( async ) {
+    if ( pd->mapped != NULL ) {
+        // The -input file is mapped and indexed already.
+        async = FALSE;
+    }
+    else if ( async ) {
         unsigned int pre_read = 25;
         find_arg_uint ( "-async-pre-read", &pre_read );
         async = get_dmenu_async ( pd, pre_read );
@@ -682,8 +960,8 @@ int dmenu_switcher_dialog ( void )
     char *select = NULL;
     find_arg_str ( "-select", &select );
     if ( select != NULL ) {
-        GRegex       **tokens = tokenize ( select, config.case_sensitive );
-        unsigned int i        = 0;
+        rofi_int_matcher **tokens = tokenize ( select, config.case_sensitive );
+        unsigned int     i        = 0;
         for ( i = 0; i < cmd_list_length; i++ ) {
             if ( helper_token_match ( tokens, cmd_list[i] ) ) {
                 pd->selected_line = i;
@@ -693,8 +971,8 @@ int dmenu_switcher_dialog ( void )
         tokenize_free ( tokens );
     }
     if ( find_arg ( "-dump" ) >= 0 ) {
-        GRegex       **tokens = tokenize ( config.filter ? config.filter : "", config.case_sensitive );
-        unsigned int i        = 0;
+        rofi_int_matcher **tokens = tokenize ( config.filter ? config.filter : "", config.case_sensitive );
+        unsigned int     i        = 0;
         for ( i = 0; i < cmd_list_length; i++ ) {
             if ( tokens == NULL || helper_token_match ( tokens, cmd_list[i] ) ) {
                 dmenu_output_formatted_line ( pd->format, cmd_list[i], i, config.filter );
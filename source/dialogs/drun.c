@@ -68,6 +68,8 @@ typedef struct
     char     *exec;
     /* Name of the Entry */
     char     *name;
+    /* Length of the name in characters */
+    glong    name_len;
     /* Generic Name */
     char     *generic_name;
 #ifdef GET_CAT_PARSE_TIME
@@ -271,7 +273,8 @@ static gboolean read_desktop_file ( DRunModePrivateData *pd, const char *root, c
     pd->entry_list[pd->cmd_list_length].root = g_strdup ( root );
     pd->entry_list[pd->cmd_list_length].path = g_strdup ( path );
     gchar *n = g_key_file_get_locale_string ( kf, "Desktop Entry", "Name", NULL, NULL );
-    pd->entry_list[pd->cmd_list_length].name = n;
+    pd->entry_list[pd->cmd_list_length].name     = n;
+    pd->entry_list[pd->cmd_list_length].name_len = n ? g_utf8_strlen ( n, -1 ) : 0;
     gchar *gn = g_key_file_get_locale_string ( kf, "Desktop Entry", "GenericName", NULL, NULL );
     pd->entry_list[pd->cmd_list_length].generic_name = gn;
 #ifdef GET_CAT_PARSE_TIME
@@ -510,14 +513,14 @@ static char *drun_get_completion ( const Mode *sw, unsigned int index )
     }
 }
 
-static int drun_token_match ( const Mode *data, GRegex **tokens, unsigned int index )
+static int drun_token_match ( const Mode *data, rofi_int_matcher **tokens, unsigned int index )
 {
     DRunModePrivateData *rmpd = (DRunModePrivateData *) mode_get_private_data ( data );
     int                 match = 1;
     if ( tokens ) {
         for ( int j = 0; match && tokens != NULL && tokens[j] != NULL; j++ ) {
-            int    test        = 0;
-            GRegex *ftokens[2] = { tokens[j], NULL };
+            int              test        = 0;
+            rofi_int_matcher *ftokens[2] = { tokens[j], NULL };
             // Match name
             if ( rmpd->entry_list[index].name &&
                  helper_token_match ( ftokens, rmpd->entry_list[index].name ) ) {
@@ -555,6 +558,39 @@ static int drun_token_match ( const Mode *data, GRegex **tokens, unsigned int in
     return match;
 }
 
+/**
+ * Fields are the name, generic name, executable and then each of the categories,
+ * the same strings drun_token_match() looks at.
+ */
+static const char *drun_get_match_string ( const Mode *sw, unsigned int index, unsigned int field, glong *length )
+{
+    DRunModePrivateData *rmpd = (DRunModePrivateData *) mode_get_private_data ( sw );
+    DRunModeEntry       *dr   = &( rmpd->entry_list[index] );
+    switch ( field )
+    {
+    case 0:
+        if ( dr->name == NULL ) {
+            return "";
+        }
+        *length = dr->name_len;
+        return dr->name;
+    case 1:
+        return dr->generic_name ? dr->generic_name : "";
+    case 2:
+        return dr->exec;
+    default:
+        break;
+    }
+#ifdef GET_CAT_PARSE_TIME
+    for ( unsigned int iter = 0; dr->categories && dr->categories[iter]; iter++ ) {
+        if ( iter == ( field - 3 ) ) {
+            return dr->categories[iter];
+        }
+    }
+#endif
+    return NULL;
+}
+
 static unsigned int drun_mode_get_num_entries ( const Mode *sw )
 {
     const DRunModePrivateData *pd = (const DRunModePrivateData *) mode_get_private_data ( sw );
@@ -573,6 +609,7 @@ Mode drun_mode =
     ._get_completion    = drun_get_completion,
     ._get_display_value = _get_display_value,
     ._preprocess_input  = NULL,
+    ._get_match_string  = drun_get_match_string,
     .private_data       = NULL,
     .free               = NULL
 };
@@ -104,13 +104,18 @@ static char *_get_display_value ( const Mode *sw, unsigned int selected_line, in
     return g_strdup ( pd->messages[selected_line] );
 }
 static int help_keys_token_match ( const Mode *data,
-                                   GRegex **tokens,
+                                   rofi_int_matcher **tokens,
                                    unsigned int index
                                    )
 {
     KeysHelpModePrivateData *rmpd = (KeysHelpModePrivateData *) mode_get_private_data ( data );
     return helper_token_match ( tokens, rmpd->messages[index] );
 }
+static const char *help_keys_get_match_string ( const Mode *sw, unsigned int index, unsigned int field, G_GNUC_UNUSED glong *length )
+{
+    KeysHelpModePrivateData *rmpd = (KeysHelpModePrivateData *) mode_get_private_data ( sw );
+    return field == 0 ? rmpd->messages[index] : NULL;
+}
 
 static unsigned int help_keys_mode_get_num_entries ( const Mode *sw )
 {
@@ -129,6 +134,7 @@ Mode help_keys_mode =
     ._destroy           = help_keys_mode_destroy,
     ._token_match       = help_keys_token_match,
     ._get_completion    = NULL,
+    ._get_match_string  = help_keys_get_match_string,
     ._get_display_value = _get_display_value,
     .private_data       = NULL,
     .free               = NULL
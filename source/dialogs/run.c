@@ -398,11 +398,21 @@ static char *_get_display_value ( const Mode *sw, unsigned int selected_line, G_
     const RunModePrivateData *rmpd = (const RunModePrivateData *) sw->private_data;
     return get_entry ? g_strdup ( rmpd->cmd_list[selected_line] ) : NULL;
 }
-static int run_token_match ( const Mode *sw, GRegex **tokens, unsigned int index )
+static int run_token_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
 {
     const RunModePrivateData *rmpd = (const RunModePrivateData *) sw->private_data;
     return helper_token_match ( tokens, rmpd->cmd_list[index] );
 }
+static void run_token_match_range ( const Mode *sw, rofi_int_matcher **tokens, unsigned int start, unsigned int stop, guint32 *matches )
+{
+    const RunModePrivateData *rmpd = (const RunModePrivateData *) sw->private_data;
+    helper_token_match_range ( tokens, rmpd->cmd_list, start, stop, matches );
+}
+static const char *run_get_match_string ( const Mode *sw, unsigned int index, unsigned int field, G_GNUC_UNUSED glong *length )
+{
+    const RunModePrivateData *rmpd = (const RunModePrivateData *) sw->private_data;
+    return field == 0 ? rmpd->cmd_list[index] : NULL;
+}
 
 #include "mode-private.h"
 Mode run_mode =
@@ -414,9 +424,11 @@ Mode run_mode =
     ._result            = run_mode_result,
     ._destroy           = run_mode_destroy,
     ._token_match       = run_token_match,
+    ._token_match_range = run_token_match_range,
     ._get_display_value = _get_display_value,
     ._get_completion    = NULL,
     ._preprocess_input  = NULL,
+    ._get_match_string  = run_get_match_string,
     .private_data       = NULL,
     .free               = NULL
 };
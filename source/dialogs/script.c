@@ -167,12 +167,24 @@ static char *_get_display_value ( const Mode *sw, unsigned int selected_line, G_
     return get_entry ? g_strdup ( rmpd->cmd_list[selected_line] ) : NULL;
 }
 
-static int script_token_match ( const Mode *sw, GRegex **tokens, unsigned int index )
+static int script_token_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
 {
     ScriptModePrivateData *rmpd = sw->private_data;
     return helper_token_match ( tokens, rmpd->cmd_list[index] );
 }
 
+static void script_token_match_range ( const Mode *sw, rofi_int_matcher **tokens, unsigned int start, unsigned int stop, guint32 *matches )
+{
+    ScriptModePrivateData *rmpd = sw->private_data;
+    helper_token_match_range ( tokens, rmpd->cmd_list, start, stop, matches );
+}
+
+static const char *script_get_match_string ( const Mode *sw, unsigned int index, unsigned int field, G_GNUC_UNUSED glong *length )
+{
+    ScriptModePrivateData *rmpd = sw->private_data;
+    return field == 0 ? rmpd->cmd_list[index] : NULL;
+}
+
 #include "mode-private.h"
 Mode *script_switcher_parse_setup ( const char *str )
 {
@@ -198,8 +210,10 @@ Mode *script_switcher_parse_setup ( const char *str )
         sw->_result            = script_mode_result;
         sw->_destroy           = script_mode_destroy;
         sw->_token_match       = script_token_match;
+        sw->_token_match_range = script_token_match_range;
         sw->_get_completion    = NULL,
         sw->_preprocess_input  = NULL,
+        sw->_get_match_string  = script_get_match_string,
         sw->_get_display_value = _get_display_value;
 
         return sw;
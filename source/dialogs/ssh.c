@@ -521,11 +521,42 @@ static char *_get_display_value ( const Mode *sw, unsigned int selected_line, G_
  *
  * @returns TRUE if matches
  */
-static int ssh_token_match ( const Mode *sw, GRegex **tokens, unsigned int index )
+static int ssh_token_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
 {
     SSHModePrivateData *rmpd = (SSHModePrivateData *) mode_get_private_data ( sw );
     return helper_token_match ( tokens, rmpd->hosts_list[index] );
 }
+
+/**
+ * @param sw Object handle to the SSH Mode object
+ * @param tokens The set of tokens to match against
+ * @param start The first entry to match
+ * @param stop The entry after the last entry to match
+ * @param matches Bitmap of the matching entries [out]
+ *
+ * Match a range of entries against the set of tokens.
+ */
+static void ssh_token_match_range ( const Mode *sw, rofi_int_matcher **tokens, unsigned int start, unsigned int stop, guint32 *matches )
+{
+    SSHModePrivateData *rmpd = (SSHModePrivateData *) mode_get_private_data ( sw );
+    helper_token_match_range ( tokens, rmpd->hosts_list, start, stop, matches );
+}
+
+/**
+ * @param sw Object handle to the SSH Mode object
+ * @param index The index of the entry
+ * @param field The field to get
+ * @param length The length of the string [out]
+ *
+ * Get the host name the entry is matched against.
+ *
+ * @returns the host name, or NULL for any field but the first.
+ */
+static const char *ssh_get_match_string ( const Mode *sw, unsigned int index, unsigned int field, G_GNUC_UNUSED glong *length )
+{
+    SSHModePrivateData *rmpd = (SSHModePrivateData *) mode_get_private_data ( sw );
+    return field == 0 ? rmpd->hosts_list[index] : NULL;
+}
 #include "mode-private.h"
 Mode ssh_mode =
 {
@@ -536,9 +567,11 @@ Mode ssh_mode =
     ._result            = ssh_mode_result,
     ._destroy           = ssh_mode_destroy,
     ._token_match       = ssh_token_match,
+    ._token_match_range = ssh_token_match_range,
     ._get_display_value = _get_display_value,
     ._get_completion    = NULL,
     ._preprocess_input  = NULL,
+    ._get_match_string  = ssh_get_match_string,
     .private_data       = NULL,
     .free               = NULL
 };
@@ -321,7 +321,7 @@ static client* window_client ( ModeModePrivateData *pd, xcb_window_t win )
     g_free ( attr );
     return c;
 }
-static int window_match ( const Mode *sw, GRegex **tokens, unsigned int index )
+static int window_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
 {
     ModeModePrivateData *rmpd = (ModeModePrivateData *) mode_get_private_data ( sw );
     int                 match = 1;
@@ -338,7 +338,7 @@ static int window_match ( const Mode *sw, GRegex **tokens, unsigned int index )
             // Now we want it to match only one item at the time.
             // If hack not in place it would not match queries spanning multiple fields.
             // e.g. when searching 'title element' and 'class element'
-            GRegex *ftokens[2] = { tokens[j], NULL };
+            rofi_int_matcher *ftokens[2] = { tokens[j], NULL };
             if ( c->title != NULL && c->title[0] != '\0' ) {
                 test = helper_token_match ( ftokens, c->title );
             }
@@ -367,6 +367,38 @@ static int window_match ( const Mode *sw, GRegex **tokens, unsigned int index )
     return match;
 }
 
+static const char *window_get_match_string ( const Mode *sw, unsigned int index, unsigned int field, G_GNUC_UNUSED glong *length )
+{
+    ModeModePrivateData *rmpd = (ModeModePrivateData *) mode_get_private_data ( sw );
+    const winlist       *ids  = ( winlist * ) rmpd->ids;
+    // Same as window_match, only read from the cache.
+    int                 idx = winlist_find ( cache_client, ids->array[index] );
+    g_assert ( idx >= 0 );
+    client              *c   = cache_client->data[idx];
+    const char          *str = NULL;
+    switch ( field )
+    {
+    case 0:
+        str = c->title;
+        break;
+    case 1:
+        str = c->class;
+        break;
+    case 2:
+        str = c->role;
+        break;
+    case 3:
+        str = c->name;
+        break;
+    case 4:
+        str = c->wmdesktopstr;
+        break;
+    default:
+        return NULL;
+    }
+    return str ? str : "";
+}
+
 static unsigned int window_mode_get_num_entries ( const Mode *sw )
 {
     const ModeModePrivateData *pd = (const ModeModePrivateData *) mode_get_private_data ( sw );
@@ -739,6 +771,7 @@ Mode window_mode =
     ._get_display_value = _get_display_value,
     ._get_completion    = NULL,
     ._preprocess_input  = NULL,
+    ._get_match_string  = window_get_match_string,
     .private_data       = NULL,
     .free               = NULL
 };
@@ -754,6 +787,7 @@ Mode window_mode_cd =
     ._get_display_value = _get_display_value,
     ._get_completion    = NULL,
     ._preprocess_input  = NULL,
+    ._get_match_string  = window_get_match_string,
     .private_data       = NULL,
     .free               = NULL
 };
@@ -0,0 +1,187 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+/** The log domain of this module. */
+#define G_LOG_DOMAIN    "Fold"
+
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+#include "parallel.h"
+#include "fold.h"
+
+/** Smallest number of rows worth handing to another worker. */
+#define FOLD_MIN_CHUNK_SIZE    1024
+/** Number of rows to fold before looking if the build got cancelled. */
+#define FOLD_CANCEL_CHECK      256
+/** Offset of a row that has no folded string. */
+#define FOLD_NONE              G_MAXSIZE
+
+struct _RofiFoldCorpus
+{
+    unsigned int num_rows;
+    /** Per row the start of its folded string in text, or FOLD_NONE. */
+    gsize        *offsets;
+    /** All folded strings, each terminated by a '\0'. */
+    char         *text;
+};
+
+/**
+ * State of folding the rows, shared by the workers.
+ */
+typedef struct
+{
+    RofiFoldTextFunc func;
+    gpointer         user_data;
+    const gint       *cancel;
+    RofiFoldCorpus   *corpus;
+} FoldBuild;
+
+static inline gboolean fold_build_cancelled ( const FoldBuild *b )
+{
+    return b->cancel != NULL && g_atomic_int_get ( b->cancel );
+}
+
+/**
+ * Fold str into out, which has room for strlen(str) + 1 bytes.
+ *
+ * @returns FALSE if a character folds to a different length, or str is not valid UTF-8.
+ */
+static gboolean fold_string ( const char *str, char *out )
+{
+    while ( *str != '\0' ) {
+        unsigned char c = (unsigned char) *str;
+        if ( c < 0x80 ) {
+            *out++ = g_ascii_tolower ( c );
+            str++;
+            continue;
+        }
+        gunichar uc = g_utf8_get_char_validated ( str, -1 );
+        if ( uc == (gunichar) -1 || uc == (gunichar) -2 ) {
+            return FALSE;
+        }
+        const char *next = g_utf8_next_char ( str );
+        char       buf[6];
+        gint       len = g_unichar_to_utf8 ( rofi_fold_char ( uc ), buf );
+        if ( len != ( next - str ) ) {
+            return FALSE;
+        }
+        memcpy ( out, buf, len );
+        out += len;
+        str  = next;
+    }
+    *out = '\0';
+    return TRUE;
+}
+
+static void fold_build_measure ( G_GNUC_UNUSED unsigned int worker, G_GNUC_UNUSED unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data )
+{
+    FoldBuild *b = (FoldBuild *) user_data;
+    for ( unsigned int row = start; row < stop; row++ ) {
+        if ( ( ( row - start ) % FOLD_CANCEL_CHECK ) == 0 && fold_build_cancelled ( b ) ) {
+            return;
+        }
+        const char *str = b->func ( row, b->user_data );
+        b->corpus->offsets[row] = ( str != NULL ) ? strlen ( str ) + 1 : FOLD_NONE;
+    }
+}
+
+static void fold_build_fill ( G_GNUC_UNUSED unsigned int worker, G_GNUC_UNUSED unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data )
+{
+    FoldBuild      *b      = (FoldBuild *) user_data;
+    RofiFoldCorpus *corpus = b->corpus;
+    for ( unsigned int row = start; row < stop; row++ ) {
+        if ( ( ( row - start ) % FOLD_CANCEL_CHECK ) == 0 && fold_build_cancelled ( b ) ) {
+            return;
+        }
+        if ( corpus->offsets[row] == FOLD_NONE ) {
+            continue;
+        }
+        const char *str = b->func ( row, b->user_data );
+        if ( str == NULL || !fold_string ( str, &( corpus->text[corpus->offsets[row]] ) ) ) {
+            corpus->offsets[row] = FOLD_NONE;
+        }
+    }
+}
+
+void rofi_fold_corpus_free ( RofiFoldCorpus *corpus )
+{
+    if ( corpus == NULL ) {
+        return;
+    }
+    g_free ( corpus->offsets );
+    g_free ( corpus->text );
+    g_free ( corpus );
+}
+
+RofiFoldCorpus * rofi_fold_corpus_new ( unsigned int num_rows, RofiFoldTextFunc func, gpointer user_data, const gint *cancel )
+{
+    RofiFoldCorpus    *corpus = g_malloc0 ( sizeof ( RofiFoldCorpus ) );
+    FoldBuild         b       = {
+        .func      = func,
+        .user_data = user_data,
+        .cancel    = cancel,
+        .corpus    = corpus,
+    };
+    RofiParallelRange range;
+    corpus->num_rows = num_rows;
+    corpus->offsets  = g_malloc_n ( num_rows + 1, sizeof ( gsize ) );
+
+    // Measure the rows, then turn the lengths into offsets.
+    rofi_parallel_range_init ( &range, num_rows, FOLD_MIN_CHUNK_SIZE );
+    rofi_parallel_for ( &range, fold_build_measure, &b );
+    if ( fold_build_cancelled ( &b ) ) {
+        rofi_fold_corpus_free ( corpus );
+        return NULL;
+    }
+    gsize total = 0;
+    for ( unsigned int row = 0; row < num_rows; row++ ) {
+        if ( corpus->offsets[row] != FOLD_NONE ) {
+            gsize len = corpus->offsets[row];
+            corpus->offsets[row] = total;
+            total               += len;
+        }
+    }
+    corpus->text = g_malloc ( total + 1 );
+
+    rofi_parallel_for ( &range, fold_build_fill, &b );
+    if ( fold_build_cancelled ( &b ) ) {
+        rofi_fold_corpus_free ( corpus );
+        return NULL;
+    }
+    g_debug ( "Folded %u rows in %" G_GSIZE_FORMAT " bytes.", num_rows, total );
+    return corpus;
+}
+
+const char * rofi_fold_corpus_get ( const RofiFoldCorpus *corpus, unsigned int row )
+{
+    if ( row >= corpus->num_rows || corpus->offsets[row] == FOLD_NONE ) {
+        return NULL;
+    }
+    return &( corpus->text[corpus->offsets[row]] );
+}
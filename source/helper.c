@@ -43,12 +43,25 @@
 #include <sys/stat.h>
 #include <pwd.h>
 #include <ctype.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined ( __GNUC__ ) && ( defined ( __x86_64__ ) || defined ( __i386__ ) )
+#include <immintrin.h>
+/** The AVX2 substring search can be compiled, it is only used when the CPU supports it. */
+#define HELPER_SUBSTR_AVX2    1
+#endif
 #include <xcb/xcb.h>
 #include <pango/pango.h>
 #include <pango/pango-fontmap.h>
 #include <pango/pangocairo.h>
+#ifdef ENABLE_PCRE2
+#define PCRE2_CODE_UNIT_WIDTH    8
+#include <pcre2.h>
+#endif
 #include "helper.h"
 #include "helper-theme.h"
+#include "fold.h"
 #include "settings.h"
 #include "x11-helper.h"
 #include "rofi.h"
@@ -151,14 +164,527 @@ int helper_parse_setup ( char * string, char ***output, int *length, ... )
     return FALSE;
 }
 
-void tokenize_free ( GRegex ** tokens )
+/**
+ * Function that searches the needle of a #rofi_int_matcher in the haystack.
+ */
+typedef const char * ( *helper_substr_find_func )( const rofi_int_matcher *m, const char *h, size_t hlen );
+
+/**
+ * Compiled token.
+ */
+struct _rofi_int_matcher
+{
+    /** Held by each token array using it and by the token cache. */
+    gint                    ref_count;
+    /** The regex, used for highlighting and when there is no native matcher. */
+    GRegex                  *regex;
+#ifdef ENABLE_PCRE2
+    /** The regex compiled by PCRE2, used for matching instead of regex. NULL if not compiled. */
+    pcre2_code              *pcre;
+#endif
+    /** The needle for the native substring matcher, NULL when the regex should be used. */
+    char                    *needle;
+    /** Length of the needle in bytes. */
+    size_t                  needle_len;
+    /** Needle is lower case ASCII and ASCII letters in the haystack should be folded. */
+    gboolean                caseless;
+    /** Needle contains a 'k' or 's', these also fold to non-ASCII characters. */
+    gboolean                fold_special;
+    /** Search implementation picked for this CPU. */
+    helper_substr_find_func find;
+    /** The (folded) characters for the fuzzy matcher, NULL when not used. */
+    gunichar                *fuzzy;
+    /** Number of characters in fuzzy. */
+    size_t                  fuzzy_len;
+    /** The (folded) characters of the glob, '*' and '?' are the wildcards. NULL when not used. */
+    gunichar                *glob;
+    /** Number of characters in glob. */
+    size_t                  glob_len;
+};
+
+/**
+ * @param c The character to convert.
+ *
+ * Lower case only the ASCII letters, leaving all other bytes (including UTF-8 sequences) untouched.
+ *
+ * @returns the lower case character.
+ */
+static inline char helper_ascii_lower ( char c )
+{
+    return ( c >= 'A' && c <= 'Z' ) ? ( c | 0x20 ) : c;
+}
+
+static inline gboolean helper_substr_equal ( const rofi_int_matcher *m, const char *h )
+{
+    if ( !m->caseless ) {
+        return memcmp ( h, m->needle, m->needle_len ) == 0;
+    }
+    for ( size_t i = 0; i < m->needle_len; i++ ) {
+        if ( helper_ascii_lower ( h[i] ) != m->needle[i] ) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static const char *helper_substr_find_scalar ( const rofi_int_matcher *m, const char *h, size_t hlen )
+{
+    if ( hlen < m->needle_len ) {
+        return NULL;
+    }
+    const size_t last  = hlen - m->needle_len;
+    const char   first = m->needle[0];
+    for ( size_t i = 0; i <= last; i++ ) {
+        if ( !m->caseless ) {
+            const char *p = memchr ( &h[i], first, last - i + 1 );
+            if ( p == NULL ) {
+                return NULL;
+            }
+            i = p - h;
+        }
+        else if ( helper_ascii_lower ( h[i] ) != first ) {
+            continue;
+        }
+        if ( helper_substr_equal ( m, &h[i] ) ) {
+            return &h[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * The vectorized searches compare a block of candidate start positions at once
+ * against the first and the last byte of the needle, and only do a full
+ * compare on the positions where both matched. The remainder is done by the scalar search.
+ */
+#ifdef __SSE2__
+static inline __m128i helper_sse2_ascii_lower ( __m128i v )
+{
+    __m128i upper = _mm_and_si128 ( _mm_cmpgt_epi8 ( v, _mm_set1_epi8 ( 'A' - 1 ) ),
+                                    _mm_cmplt_epi8 ( v, _mm_set1_epi8 ( 'Z' + 1 ) ) );
+    return _mm_or_si128 ( v, _mm_and_si128 ( upper, _mm_set1_epi8 ( 0x20 ) ) );
+}
+
+static const char *helper_substr_find_sse2 ( const rofi_int_matcher *m, const char *h, size_t hlen )
+{
+    const size_t  n     = m->needle_len;
+    const __m128i first = _mm_set1_epi8 ( m->needle[0] );
+    const __m128i last  = _mm_set1_epi8 ( m->needle[n - 1] );
+    size_t        i     = 0;
+    for (; ( i + n - 1 + 16 ) <= hlen; i += 16 ) {
+        __m128i bf = _mm_loadu_si128 ( (const __m128i *) ( h + i ) );
+        __m128i bl = _mm_loadu_si128 ( (const __m128i *) ( h + i + n - 1 ) );
+        if ( m->caseless ) {
+            bf = helper_sse2_ascii_lower ( bf );
+            bl = helper_sse2_ascii_lower ( bl );
+        }
+        unsigned int mask = _mm_movemask_epi8 ( _mm_and_si128 ( _mm_cmpeq_epi8 ( bf, first ), _mm_cmpeq_epi8 ( bl, last ) ) );
+        while ( mask != 0 ) {
+            unsigned int bit = __builtin_ctz ( mask );
+            if ( helper_substr_equal ( m, h + i + bit ) ) {
+                return h + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return helper_substr_find_scalar ( m, h + i, hlen - i );
+}
+#endif // __SSE2__
+
+#ifdef HELPER_SUBSTR_AVX2
+__attribute__ ( ( target ( "avx2" ) ) )
+static const char *helper_substr_find_avx2 ( const rofi_int_matcher *m, const char *h, size_t hlen )
+{
+    const size_t  n     = m->needle_len;
+    const __m256i first = _mm256_set1_epi8 ( m->needle[0] );
+    const __m256i last  = _mm256_set1_epi8 ( m->needle[n - 1] );
+    const __m256i lo    = _mm256_set1_epi8 ( 'A' - 1 );
+    const __m256i hi    = _mm256_set1_epi8 ( 'Z' + 1 );
+    const __m256i bit5  = _mm256_set1_epi8 ( 0x20 );
+    size_t        i     = 0;
+    for (; ( i + n - 1 + 32 ) <= hlen; i += 32 ) {
+        __m256i bf = _mm256_loadu_si256 ( (const __m256i *) ( h + i ) );
+        __m256i bl = _mm256_loadu_si256 ( (const __m256i *) ( h + i + n - 1 ) );
+        if ( m->caseless ) {
+            __m256i uf = _mm256_and_si256 ( _mm256_cmpgt_epi8 ( bf, lo ), _mm256_cmpgt_epi8 ( hi, bf ) );
+            __m256i ul = _mm256_and_si256 ( _mm256_cmpgt_epi8 ( bl, lo ), _mm256_cmpgt_epi8 ( hi, bl ) );
+            bf = _mm256_or_si256 ( bf, _mm256_and_si256 ( uf, bit5 ) );
+            bl = _mm256_or_si256 ( bl, _mm256_and_si256 ( ul, bit5 ) );
+        }
+        unsigned int mask = _mm256_movemask_epi8 ( _mm256_and_si256 ( _mm256_cmpeq_epi8 ( bf, first ), _mm256_cmpeq_epi8 ( bl, last ) ) );
+        while ( mask != 0 ) {
+            unsigned int bit = __builtin_ctz ( mask );
+            if ( helper_substr_equal ( m, h + i + bit ) ) {
+                return h + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return helper_substr_find_scalar ( m, h + i, hlen - i );
+}
+#endif // HELPER_SUBSTR_AVX2
+
+static helper_substr_find_func helper_substr_find_select ( void )
+{
+#ifdef HELPER_SUBSTR_AVX2
+    if ( __builtin_cpu_supports ( "avx2" ) ) {
+        return helper_substr_find_avx2;
+    }
+#endif
+#ifdef __SSE2__
+    return helper_substr_find_sse2;
+#else
+    return helper_substr_find_scalar;
+#endif
+}
+
+/**
+ * @param m     The matcher to setup.
+ * @param input The token.
+ * @param case_sensitive Whether case is significant.
+ *
+ * Setup the native substring matcher, used by #MM_NORMAL.
+ * Case sensitive search is a plain byte compare. Case insensitive search is only done natively
+ * for ASCII needles, others need unicode case folding and are left to the regex.
+ */
+static void helper_substr_setup ( rofi_int_matcher *m, const char *input, int case_sensitive )
+{
+    size_t len = strlen ( input );
+    if ( len == 0 ) {
+        return;
+    }
+    if ( !case_sensitive ) {
+        for ( size_t i = 0; i < len; i++ ) {
+            if ( input[i] & 0x80 ) {
+                return;
+            }
+        }
+    }
+    m->needle     = g_strndup ( input, len );
+    m->needle_len = len;
+    m->caseless   = !case_sensitive;
+    if ( m->caseless ) {
+        for ( size_t i = 0; i < len; i++ ) {
+            m->needle[i]     = helper_ascii_lower ( m->needle[i] );
+            m->fold_special |= ( m->needle[i] == 'k' || m->needle[i] == 's' );
+        }
+    }
+    m->find = helper_substr_find_select ();
+}
+
+/**
+ * @param p        Pointer to the UTF-8 character to decode.
+ * @param caseless If the character should be case folded.
+ * @param c        Set to the decoded character.
+ *
+ * Decode the next character, ASCII is handled without calling into glib.
+ *
+ * @returns pointer to the next character.
+ */
+static inline const char *helper_fuzzy_next_char ( const char *p, gboolean caseless, gunichar *c )
+{
+    if ( !( *p & 0x80 ) ) {
+        *c = caseless ? (gunichar) helper_ascii_lower ( *p ) : (gunichar) *p;
+        return p + 1;
+    }
+    *c = g_utf8_get_char ( p );
+    if ( caseless ) {
+        *c = rofi_fold_char ( *c );
+    }
+    return g_utf8_next_char ( p );
+}
+
+/**
+ * @param m     The matcher to setup.
+ * @param input The token.
+ * @param case_sensitive Whether case is significant.
+ *
+ * Setup the fuzzy matcher, used by #MM_FUZZY.
+ */
+static void helper_fuzzy_setup ( rofi_int_matcher *m, const char *input, int case_sensitive )
+{
+    m->caseless  = !case_sensitive;
+    m->fuzzy     = g_malloc_n ( g_utf8_strlen ( input, -1 ) + 1, sizeof ( gunichar ) );
+    m->fuzzy_len = 0;
+    for ( const char *p = input; *p != '\0'; ) {
+        p = helper_fuzzy_next_char ( p, m->caseless, &( m->fuzzy[m->fuzzy_len++] ) );
+    }
+}
+
+/**
+ * @param m         The fuzzy matcher.
+ * @param input     The string to match against.
+ * @param positions If not NULL, filled with the byte offset of each matched character. (m->fuzzy_len entries)
+ *
+ * Check if the characters of the token appear in order on one line of input. Leftmost characters are taken,
+ * this runs in linear time and never backtracks.
+ *
+ * @returns TRUE if input matches.
+ */
+static gboolean helper_fuzzy_find ( const rofi_int_matcher *m, const char *input, int *positions )
+{
+    size_t     ni = 0;
+    const char *p = input;
+    while ( ni < m->fuzzy_len && *p != '\0' ) {
+        gunichar   c;
+        const char *n = helper_fuzzy_next_char ( p, m->caseless, &c );
+        if ( c == m->fuzzy[ni] ) {
+            if ( positions != NULL ) {
+                positions[ni] = p - input;
+            }
+            ni++;
+        }
+        else if ( c == '\n' ) {
+            // Like the regex it replaces, a match does not span lines: start over on the next one.
+            ni = 0;
+        }
+        p = n;
+    }
+    return ni == m->fuzzy_len;
+}
+
+/**
+ * @param m     The matcher to setup.
+ * @param input The token.
+ * @param case_sensitive Whether case is significant.
+ *
+ * Setup the glob matcher, used by #MM_GLOB.
+ */
+static void helper_glob_setup ( rofi_int_matcher *m, const char *input, int case_sensitive )
+{
+    m->caseless = !case_sensitive;
+    m->glob     = g_malloc_n ( g_utf8_strlen ( input, -1 ) + 1, sizeof ( gunichar ) );
+    m->glob_len = 0;
+    for ( const char *p = input; *p != '\0'; ) {
+        gunichar c;
+        p = helper_fuzzy_next_char ( p, m->caseless, &c );
+        // A run of '*' matches the same as one.
+        if ( c == '*' && m->glob_len > 0 && m->glob[m->glob_len - 1] == '*' ) {
+            continue;
+        }
+        m->glob[m->glob_len++] = c;
+    }
+}
+
+/**
+ * @param c The character to check.
+ *
+ * @returns TRUE if the glob wildcard '?' does not match c, the characters '\s' matches in a regex.
+ */
+static inline gboolean helper_glob_is_space ( gunichar c )
+{
+    return g_unichar_isspace ( c ) || c == 0x0B || c == 0x85;
+}
+
+/**
+ * @param m     The glob matcher.
+ * @param input The string to match against.
+ *
+ * Check if the glob matches anywhere in input. '*' matches any run of characters within a line and
+ * '?' one character that is not white space, like the regex globs used to be translated to.
+ *
+ * Only the last '*' seen is ever retried, one character further each time: the part of the glob
+ * before it already matched as early as possible, so retrying an earlier '*' cannot find a match
+ * the last one does not. This needs no recursion and no backtracking over earlier parts.
+ *
+ * @returns TRUE if input matches.
+ */
+static gboolean helper_glob_find ( const rofi_int_matcher *m, const char *input )
+{
+    // Index in the glob after the last '*', 0 when there was none yet.
+    size_t     star = 0;
+    // Where to retry on a mismatch: the end of the run matched by the last '*', or the start of the match.
+    const char *retry = input;
+    const char *p     = input;
+    size_t     gi     = 0;
+    while ( gi < m->glob_len ) {
+        if ( m->glob[gi] == '*' ) {
+            star  = ++gi;
+            retry = p;
+            continue;
+        }
+        if ( *p == '\0' ) {
+            // Up to the next '*' every glob character takes one character, starting later leaves even fewer.
+            return FALSE;
+        }
+        gunichar   c;
+        const char *n = helper_fuzzy_next_char ( p, m->caseless, &c );
+        if ( m->glob[gi] == '?' ? !helper_glob_is_space ( c ) : m->glob[gi] == c ) {
+            p = n;
+            gi++;
+            continue;
+        }
+        retry = helper_fuzzy_next_char ( retry, FALSE, &c );
+        if ( c == '\n' ) {
+            // '*' does not match a newline, start over on the next line.
+            star = 0;
+        }
+        p  = retry;
+        gi = star;
+    }
+    return TRUE;
+}
+
+#ifdef ENABLE_PCRE2
+static void helper_pcre_match_data_free ( gpointer data )
+{
+    pcre2_match_data_free ( (pcre2_match_data *) data );
+}
+
+/** PCRE2 match data of this thread, freed when the thread exits. */
+static GPrivate helper_pcre_match_data_key = G_PRIVATE_INIT ( helper_pcre_match_data_free );
+
+/**
+ * @param regex The compiled GRegex.
+ *
+ * Compile the pattern of regex again with PCRE2, with the same options. The pattern is JIT compiled
+ * to machine code where PCRE2 supports it, otherwise PCRE2 interprets it.
+ *
+ * @returns the compiled pattern, or NULL if PCRE2 could not compile it.
+ */
+static pcre2_code * helper_pcre_compile ( const GRegex *regex )
+{
+    const char *pattern = g_regex_get_pattern ( regex );
+    uint32_t   options  = PCRE2_UTF | PCRE2_UCP;
+    int        error    = 0;
+    PCRE2_SIZE offset   = 0;
+    if ( g_regex_get_compile_flags ( regex ) & G_REGEX_CASELESS ) {
+        options |= PCRE2_CASELESS;
+    }
+    pcre2_code *code = pcre2_compile ( (PCRE2_SPTR) pattern, PCRE2_ZERO_TERMINATED, options, &error, &offset, NULL );
+    if ( code == NULL ) {
+        g_debug ( "PCRE2 failed to compile '%s' (error %d at %u), using GRegex.", pattern, error, (unsigned int) offset );
+        return NULL;
+    }
+    if ( pcre2_jit_compile ( code, PCRE2_JIT_COMPLETE ) != 0 ) {
+        g_debug ( "PCRE2 JIT not available for '%s'.", pattern );
+    }
+    return code;
+}
+
+/**
+ * @param code  The pattern compiled by PCRE2.
+ * @param input The string to match against.
+ *
+ * @returns TRUE if input matches.
+ */
+static gboolean helper_pcre_match ( const pcre2_code *code, const char *input )
+{
+    pcre2_match_data *md = g_private_get ( &helper_pcre_match_data_key );
+    if ( md == NULL ) {
+        // Only if it matches is needed, not where.
+        md = pcre2_match_data_create ( 1, NULL );
+        g_private_set ( &helper_pcre_match_data_key, md );
+    }
+    // Like GRegex, expects valid UTF-8 and does not check it again for every match.
+    return pcre2_match ( code, (PCRE2_SPTR) input, PCRE2_ZERO_TERMINATED, 0, PCRE2_NO_UTF_CHECK, md, NULL ) >= 0;
+}
+#endif
+
+/**
+ * @param m     The matcher.
+ * @param input The string to match against.
+ *
+ * @returns TRUE if input matches.
+ */
+static gboolean helper_matcher_match ( const rofi_int_matcher *m, const char *input )
+{
+    if ( m->fuzzy != NULL ) {
+        return helper_fuzzy_find ( m, input, NULL );
+    }
+    if ( m->glob != NULL ) {
+        return helper_glob_find ( m, input );
+    }
+    if ( m->needle != NULL ) {
+        size_t len = strlen ( input );
+        if ( m->find ( m, input, len ) != NULL ) {
+            return TRUE;
+        }
+        // Ignoring case, 'k' and 's' also match KELVIN SIGN (U+212A) and LATIN SMALL LETTER LONG S (U+017F).
+        // Leave strings that can contain these to the regex.
+        if ( !m->fold_special || ( memchr ( input, 0xE2, len ) == NULL && memchr ( input, 0xC5, len ) == NULL ) ) {
+            return FALSE;
+        }
+    }
+#ifdef ENABLE_PCRE2
+    if ( m->pcre != NULL ) {
+        return helper_pcre_match ( m->pcre, input );
+    }
+#endif
+    return g_regex_match ( m->regex, input, 0, NULL );
+}
+
+/** Number of compiled tokens kept for reuse. */
+#define TOKEN_CACHE_SIZE    32
+
+/**
+ * A compiled token kept for reuse, see create_matcher_cached().
+ */
+typedef struct
+{
+    /** The token, NULL for an unused entry. */
+    char             *text;
+    /** Matching method the token was compiled for. */
+    int              method;
+    /** Case sensitivity the token was compiled for. */
+    int              case_sensitive;
+    rofi_int_matcher *matcher;
+    /** Value of token_cache_clock when last used, to find the least recently used entry. */
+    guint64          last_used;
+} TokenCacheEntry;
+
+/** The compiled tokens. */
+static TokenCacheEntry token_cache[TOKEN_CACHE_SIZE];
+/** Counts the lookups in the token cache. */
+static guint64         token_cache_clock = 0;
+/** Protects the token cache. */
+static GMutex          token_cache_lock;
+
+static rofi_int_matcher * helper_matcher_ref ( rofi_int_matcher *m )
+{
+    g_atomic_int_inc ( &( m->ref_count ) );
+    return m;
+}
+
+static void helper_matcher_unref ( rofi_int_matcher *m )
+{
+    if ( !g_atomic_int_dec_and_test ( &( m->ref_count ) ) ) {
+        return;
+    }
+    if ( m->regex != NULL ) {
+        g_regex_unref ( m->regex );
+    }
+#ifdef ENABLE_PCRE2
+    pcre2_code_free ( m->pcre );
+#endif
+    g_free ( m->needle );
+    g_free ( m->fuzzy );
+    g_free ( m->glob );
+    g_free ( m );
+}
+
+void tokenize_free ( rofi_int_matcher **tokens )
 {
     for ( size_t i = 0; tokens && tokens[i]; i++ ) {
-        g_regex_unref ( (GRegex *) tokens[i] );
+        helper_matcher_unref ( tokens[i] );
     }
     g_free ( tokens );
 }
 
+void tokenize_cache_clear ( void )
+{
+    g_mutex_lock ( &token_cache_lock );
+    for ( unsigned int i = 0; i < TOKEN_CACHE_SIZE; i++ ) {
+        if ( token_cache[i].text != NULL ) {
+            g_free ( token_cache[i].text );
+            helper_matcher_unref ( token_cache[i].matcher );
+        }
+    }
+    memset ( token_cache, 0, sizeof ( token_cache ) );
+    token_cache_clock = 0;
+    g_mutex_unlock ( &token_cache_lock );
+}
+
 static gchar *glob_to_regex ( const char *input )
 {
     gchar  *r    = g_regex_escape_string ( input, -1 );
@@ -176,37 +702,6 @@ static gchar *glob_to_regex ( const char *input )
     }
     return r;
 }
-static gchar *fuzzy_to_regex ( const char * input )
-{
-    GString *str = g_string_new ( "" );
-    gchar   *r   = g_regex_escape_string ( input, -1 );
-    gchar   *iter;
-    int     first = 1;
-    for ( iter = r; iter && *iter != '\0'; iter = g_utf8_next_char ( iter ) ) {
-        if ( first ) {
-            g_string_append ( str, "(" );
-        }
-        else {
-            g_string_append ( str, ".*(" );
-        }
-        if ( *iter == '\\' ) {
-            g_string_append_c ( str, '\\' );
-            iter = g_utf8_next_char ( iter );
-            // If EOL, break out of for loop.
-            if ( ( *iter ) == '\0' ) {
-                break;
-            }
-        }
-        g_string_append_unichar ( str, g_utf8_get_char ( iter ) );
-        g_string_append ( str, ")" );
-        first = 0;
-    }
-    g_free ( r );
-    char *retv = str->str;
-    g_string_free ( str, FALSE );
-    return retv;
-}
-
 // Macro for quickly generating regex for matching.
 static inline GRegex * R ( const char *s, int case_sensitive  )
 {
@@ -232,11 +727,6 @@ static GRegex * create_regex ( const char *input, int case_sensitive )
             g_free ( r );
         }
         break;
-    case MM_FUZZY:
-        r    = fuzzy_to_regex ( input );
-        retv = R ( r, case_sensitive );
-        g_free ( r );
-        break;
     default:
         r    = g_regex_escape_string ( input, -1 );
         retv = R ( r, case_sensitive );
@@ -245,7 +735,76 @@ static GRegex * create_regex ( const char *input, int case_sensitive )
     }
     return retv;
 }
-GRegex **tokenize ( const char *input, int case_sensitive )
+
+static rofi_int_matcher * create_matcher ( const char *input, int case_sensitive )
+{
+    rofi_int_matcher *retv = g_malloc0 ( sizeof ( rofi_int_matcher ) );
+    retv->ref_count = 1;
+    if ( config.matching_method == MM_FUZZY ) {
+        helper_fuzzy_setup ( retv, input, case_sensitive );
+        return retv;
+    }
+    retv->regex = create_regex ( input, case_sensitive );
+    if ( config.matching_method == MM_NORMAL ) {
+        helper_substr_setup ( retv, input, case_sensitive );
+    }
+    else if ( config.matching_method == MM_GLOB ) {
+        // The regex is still used for highlighting.
+        helper_glob_setup ( retv, input, case_sensitive );
+    }
+#ifdef ENABLE_PCRE2
+    // Regex tokens match with the regex on every row.
+    if ( retv->needle == NULL && retv->glob == NULL && retv->regex != NULL ) {
+        retv->pcre = helper_pcre_compile ( retv->regex );
+    }
+#endif
+    return retv;
+}
+
+/**
+ * @param input The token.
+ * @param case_sensitive Whether case is significant.
+ *
+ * Get the compiled token from the cache, or compile it and add it in place of the least recently used one.
+ * Typing a character usually changes only the last token, so the other tokens are not compiled again.
+ *
+ * @returns the compiled token, release with helper_matcher_unref()
+ */
+static rofi_int_matcher * create_matcher_cached ( const char *input, int case_sensitive )
+{
+    int              method  = config.matching_method;
+    TokenCacheEntry  *oldest = &( token_cache[0] );
+    rofi_int_matcher *retv   = NULL;
+    g_mutex_lock ( &token_cache_lock );
+    token_cache_clock++;
+    for ( unsigned int i = 0; i < TOKEN_CACHE_SIZE; i++ ) {
+        TokenCacheEntry *e = &( token_cache[i] );
+        if ( e->text != NULL && e->method == method && e->case_sensitive == case_sensitive && strcmp ( e->text, input ) == 0 ) {
+            e->last_used = token_cache_clock;
+            retv         = helper_matcher_ref ( e->matcher );
+            break;
+        }
+        if ( e->last_used < oldest->last_used ) {
+            oldest = e;
+        }
+    }
+    if ( retv == NULL ) {
+        retv = create_matcher ( input, case_sensitive );
+        if ( oldest->text != NULL ) {
+            g_free ( oldest->text );
+            helper_matcher_unref ( oldest->matcher );
+        }
+        oldest->text           = g_strdup ( input );
+        oldest->method         = method;
+        oldest->case_sensitive = case_sensitive;
+        oldest->matcher        = helper_matcher_ref ( retv );
+        oldest->last_used      = token_cache_clock;
+    }
+    g_mutex_unlock ( &token_cache_lock );
+    return retv;
+}
+
+rofi_int_matcher **tokenize ( const char *input, int case_sensitive )
 {
     if ( input == NULL ) {
         return NULL;
@@ -255,11 +814,11 @@ GRegex **tokenize ( const char *input, int case_sensitive )
         return NULL;
     }
 
-    char   *saveptr = NULL, *token;
-    GRegex **retv = NULL;
+    char             *saveptr = NULL, *token;
+    rofi_int_matcher **retv = NULL;
     if ( !config.tokenize ) {
-        retv    = g_malloc0 ( sizeof ( GRegex* ) * 2 );
-        retv[0] = (GRegex *) create_regex ( input, case_sensitive );
+        retv    = g_malloc0 ( sizeof ( rofi_int_matcher* ) * 2 );
+        retv[0] = create_matcher_cached ( input, case_sensitive );
         return retv;
     }
 
@@ -273,8 +832,8 @@ GRegex **tokenize ( const char *input, int case_sensitive )
     // strtok should still be valid for utf8.
     const char * const sep = " ";
     for ( token = strtok_r ( str, sep, &saveptr ); token != NULL; token = strtok_r ( NULL, sep, &saveptr ) ) {
-        retv                 = g_realloc ( retv, sizeof ( GRegex* ) * ( num_tokens + 2 ) );
-        retv[num_tokens]     = (GRegex *) create_regex ( token, case_sensitive );
+        retv                 = g_realloc ( retv, sizeof ( rofi_int_matcher* ) * ( num_tokens + 2 ) );
+        retv[num_tokens]     = create_matcher_cached ( token, case_sensitive );
         retv[num_tokens + 1] = NULL;
         num_tokens++;
     }
@@ -399,66 +958,139 @@ int find_arg_char ( const char * const key, char *val )
     return FALSE;
 }
 
-PangoAttrList *helper_token_match_get_pango_attr ( ThemeHighlight th, GRegex **tokens, const char *input, PangoAttrList *retv )
+static void helper_token_match_set_pango_attr_on_style ( PangoAttrList *retv, int start, int end, ThemeHighlight th )
 {
-    // Do a tokenized match.
-    if ( tokens ) {
-        for ( int j = 0; tokens[j]; j++ ) {
-            GMatchInfo *gmi = NULL;
-            g_regex_match ( (GRegex *) tokens[j], input, G_REGEX_MATCH_PARTIAL, &gmi );
-            while ( g_match_info_matches ( gmi ) ) {
-                int count = g_match_info_get_match_count ( gmi );
-                for ( int index = ( count > 1 ) ? 1 : 0; index < count; index++ ) {
-                    int start, end;
-                    g_match_info_fetch_pos ( gmi, index, &start, &end );
-                    if ( th.style & HL_BOLD ) {
-                        PangoAttribute *pa = pango_attr_weight_new ( PANGO_WEIGHT_BOLD );
-                        pa->start_index = start;
-                        pa->end_index   = end;
-                        pango_attr_list_insert ( retv, pa );
-                    }
-                    if ( th.style & HL_UNDERLINE ) {
-                        PangoAttribute *pa = pango_attr_underline_new ( PANGO_UNDERLINE_SINGLE );
-                        pa->start_index = start;
-                        pa->end_index   = end;
-                        pango_attr_list_insert ( retv, pa );
-                    }
-                    if ( th.style & HL_ITALIC ) {
-                        PangoAttribute *pa = pango_attr_style_new ( PANGO_STYLE_ITALIC );
-                        pa->start_index = start;
-                        pa->end_index   = end;
-                        pango_attr_list_insert ( retv, pa );
-                    }
-                    if ( th.style & HL_COLOR ) {
-                        PangoAttribute *pa = pango_attr_foreground_new (
-                            th.color.red * 65535,
-                            th.color.green * 65535,
-                            th.color.blue * 65535 );
-                        pa->start_index = start;
-                        pa->end_index   = end;
-                        pango_attr_list_insert ( retv, pa );
-                    }
+    if ( th.style & HL_BOLD ) {
+        PangoAttribute *pa = pango_attr_weight_new ( PANGO_WEIGHT_BOLD );
+        pa->start_index = start;
+        pa->end_index   = end;
+        pango_attr_list_insert ( retv, pa );
+    }
+    if ( th.style & HL_UNDERLINE ) {
+        PangoAttribute *pa = pango_attr_underline_new ( PANGO_UNDERLINE_SINGLE );
+        pa->start_index = start;
+        pa->end_index   = end;
+        pango_attr_list_insert ( retv, pa );
+    }
+    if ( th.style & HL_ITALIC ) {
+        PangoAttribute *pa = pango_attr_style_new ( PANGO_STYLE_ITALIC );
+        pa->start_index = start;
+        pa->end_index   = end;
+        pango_attr_list_insert ( retv, pa );
+    }
+    if ( th.style & HL_COLOR ) {
+        PangoAttribute *pa = pango_attr_foreground_new (
+            th.color.red * 65535,
+            th.color.green * 65535,
+            th.color.blue * 65535 );
+        pa->start_index = start;
+        pa->end_index   = end;
+        pango_attr_list_insert ( retv, pa );
+    }
+}
+
+/**
+ * @param m     The matcher.
+ * @param input The string to search.
+ * @param spans The array to add the matched parts to.
+ *
+ * Find all parts of input the matcher matches, for highlighting.
+ */
+static void helper_matcher_get_spans ( const rofi_int_matcher *m, const char *input, GArray *spans )
+{
+    if ( m->fuzzy != NULL ) {
+        int positions[m->fuzzy_len];
+        if ( helper_fuzzy_find ( m, input, positions ) ) {
+            // Runs of consecutive matched characters make one span.
+            for ( size_t i = 0; i < m->fuzzy_len; ) {
+                rofi_match_span span = { positions[i], g_utf8_next_char ( &input[positions[i]] ) - input };
+                for ( i++; i < m->fuzzy_len && positions[i] == span.end; i++ ) {
+                    span.end = g_utf8_next_char ( &input[span.end] ) - input;
                 }
-                g_match_info_next ( gmi, NULL );
+                g_array_append_val ( spans, span );
             }
-            g_match_info_free ( gmi );
         }
+        return;
+    }
+    if ( m->needle != NULL ) {
+        size_t len = strlen ( input );
+        // Like helper_matcher_match(), strings that can contain the special folds are left to the regex.
+        if ( !m->fold_special || ( memchr ( input, 0xE2, len ) == NULL && memchr ( input, 0xC5, len ) == NULL ) ) {
+            for ( const char *p = input; ( p = m->find ( m, p, len - ( p - input ) ) ) != NULL; p += m->needle_len ) {
+                rofi_match_span span = { p - input, p - input + m->needle_len };
+                g_array_append_val ( spans, span );
+            }
+            return;
+        }
+    }
+    GMatchInfo *gmi = NULL;
+    g_regex_match ( m->regex, input, G_REGEX_MATCH_PARTIAL, &gmi );
+    while ( g_match_info_matches ( gmi ) ) {
+        int count = g_match_info_get_match_count ( gmi );
+        for ( int index = ( count > 1 ) ? 1 : 0; index < count; index++ ) {
+            rofi_match_span span;
+            g_match_info_fetch_pos ( gmi, index, &( span.start ), &( span.end ) );
+            g_array_append_val ( spans, span );
+        }
+        g_match_info_next ( gmi, NULL );
+    }
+    g_match_info_free ( gmi );
+}
+
+GArray *helper_token_match_get_spans ( rofi_int_matcher **tokens, const char *input )
+{
+    GArray *spans = g_array_new ( FALSE, FALSE, sizeof ( rofi_match_span ) );
+    for ( int j = 0; tokens && tokens[j]; j++ ) {
+        helper_matcher_get_spans ( tokens[j], input, spans );
+    }
+    return spans;
+}
+
+PangoAttrList *helper_match_spans_get_pango_attr ( ThemeHighlight th, const GArray *spans, PangoAttrList *retv )
+{
+    for ( guint i = 0; i < spans->len; i++ ) {
+        const rofi_match_span *span = &g_array_index ( spans, rofi_match_span, i );
+        helper_token_match_set_pango_attr_on_style ( retv, span->start, span->end, th );
     }
     return retv;
 }
 
-int helper_token_match ( GRegex * const *tokens, const char *input )
+PangoAttrList *helper_token_match_get_pango_attr ( ThemeHighlight th, rofi_int_matcher **tokens, const char *input, PangoAttrList *retv )
+{
+    GArray *spans = helper_token_match_get_spans ( tokens, input );
+    helper_match_spans_get_pango_attr ( th, spans, retv );
+    g_array_free ( spans, TRUE );
+    return retv;
+}
+
+int helper_token_match ( rofi_int_matcher * const *tokens, const char *input )
 {
     int match = TRUE;
     // Do a tokenized match.
     if ( tokens ) {
         for ( int j = 0; match && tokens[j]; j++ ) {
-            match = g_regex_match ( (const GRegex *) tokens[j], input, 0, NULL );
+            match = helper_matcher_match ( tokens[j], input );
         }
     }
     return match;
 }
 
+void helper_token_match_range ( rofi_int_matcher * const *tokens, char * const *rows, unsigned int start, unsigned int stop, guint32 *matches )
+{
+    for ( unsigned int i = start; i < stop; i++ ) {
+        if ( tokens == NULL || tokens[0] == NULL || helper_matcher_match ( tokens[0], rows[i] ) ) {
+            helper_match_bitmap_set ( matches, i - start );
+        }
+    }
+    for ( int j = 1; tokens != NULL && tokens[j] != NULL; j++ ) {
+        for ( unsigned int i = start; i < stop; i++ ) {
+            if ( helper_match_bitmap_get ( matches, i - start ) && !helper_matcher_match ( tokens[j], rows[i] ) ) {
+                matches[( i - start ) / 32] &= ~( 1u << ( ( i - start ) % 32 ) );
+            }
+        }
+    }
+}
+
 int execute_generator ( const char * cmd )
 {
     char **args = NULL;
@@ -674,8 +1306,201 @@ char *rofi_expand_path ( const char *input )
     return retv;
 }
 
-/** Return the minimum value of a,b,c */
-#define MIN3( a, b, c )    ( ( a ) < ( b ) ? ( ( a ) < ( c ) ? ( a ) : ( c ) ) : ( ( b ) < ( c ) ? ( b ) : ( c ) ) )
+/** Number of needle characters handled per machine word by the bit-parallel levenshtein. */
+#define LEVENSHTEIN_BLOCK_BITS    64
+/** Top bit of a full block. */
+#define LEVENSHTEIN_HIGH_BIT      ( G_GUINT64_CONSTANT ( 1 ) << ( LEVENSHTEIN_BLOCK_BITS - 1 ) )
+
+/**
+ * Needle prepared for the bit-parallel levenshtein distance.
+ * For every character it holds a bit-mask of the positions in the needle it occurs at,
+ * split in blocks of #LEVENSHTEIN_BLOCK_BITS characters.
+ */
+struct _LevenshteinNeedle
+{
+    /** Length of the needle in characters. */
+    glong    len;
+    /** Number of blocks. */
+    glong    blocks;
+    /** If characters should be case folded before comparing. */
+    gboolean caseless;
+    /** Masks for the ASCII characters, indexed [character * blocks + block]. */
+    guint64  *peq_ascii;
+    /** Number of different non-ASCII characters in the needle. */
+    glong    num_other;
+    /** The different non-ASCII characters in the needle. */
+    gunichar *other;
+    /** Masks for the non-ASCII characters, indexed [other index * blocks + block]. */
+    guint64  *peq_other;
+};
+
+LevenshteinNeedle *levenshtein_needle_new ( const char *needle, glong needlelen, int case_sensitive )
+{
+    LevenshteinNeedle *n = g_malloc0 ( sizeof ( LevenshteinNeedle ) );
+    n->len       = needlelen;
+    n->blocks    = ( needlelen + LEVENSHTEIN_BLOCK_BITS - 1 ) / LEVENSHTEIN_BLOCK_BITS;
+    n->caseless  = !case_sensitive;
+    n->peq_ascii = g_malloc0_n ( 128 * n->blocks, sizeof ( guint64 ) );
+    const char *iter = needle;
+    for ( glong i = 0; i < needlelen; i++, iter = g_utf8_next_char ( iter ) ) {
+        gunichar c     = g_utf8_get_char ( iter );
+        glong    block = i / LEVENSHTEIN_BLOCK_BITS;
+        guint64  bit   = G_GUINT64_CONSTANT ( 1 ) << ( i % LEVENSHTEIN_BLOCK_BITS );
+        if ( n->caseless ) {
+            c = rofi_fold_char ( c );
+        }
+        if ( c < 128 ) {
+            n->peq_ascii[c * n->blocks + block] |= bit;
+            // Upper case ASCII in the haystack is looked up without lowering it first.
+            if ( n->caseless && c >= 'a' && c <= 'z' ) {
+                n->peq_ascii[( c - 'a' + 'A' ) * n->blocks + block] |= bit;
+            }
+            continue;
+        }
+        glong index = 0;
+        while ( index < n->num_other && n->other[index] != c ) {
+            index++;
+        }
+        if ( index == n->num_other ) {
+            n->num_other++;
+            n->other     = g_realloc_n ( n->other, n->num_other, sizeof ( gunichar ) );
+            n->peq_other = g_realloc_n ( n->peq_other, n->num_other * n->blocks, sizeof ( guint64 ) );
+            n->other[index] = c;
+            memset ( &( n->peq_other[index * n->blocks] ), 0, n->blocks * sizeof ( guint64 ) );
+        }
+        n->peq_other[index * n->blocks + block] |= bit;
+    }
+    return n;
+}
+
+void levenshtein_needle_free ( LevenshteinNeedle *n )
+{
+    if ( n == NULL ) {
+        return;
+    }
+    g_free ( n->peq_ascii );
+    g_free ( n->other );
+    g_free ( n->peq_other );
+    g_free ( n );
+}
+
+/**
+ * @param n The prepared needle.
+ * @param h Pointer to the next haystack character, moved to the character after it.
+ * @param folded If the haystack is already case folded.
+ *
+ * Looks up the match masks for the next haystack character. ASCII is looked up directly.
+ *
+ * @returns the masks (one per block) or NULL if the character does not occur in the needle.
+ */
+static inline const guint64 *levenshtein_needle_peq ( const LevenshteinNeedle *n, const char **h, gboolean folded )
+{
+    unsigned char b = **h;
+    if ( b < 0x80 ) {
+        ( *h )++;
+        return &( n->peq_ascii[b * n->blocks] );
+    }
+    gunichar c = g_utf8_get_char ( *h );
+    *h = g_utf8_next_char ( *h );
+    if ( n->caseless && !folded ) {
+        c = rofi_fold_char ( c );
+    }
+    if ( c < 128 ) {
+        return &( n->peq_ascii[c * n->blocks] );
+    }
+    for ( glong index = 0; index < n->num_other; index++ ) {
+        if ( n->other[index] == c ) {
+            return &( n->peq_other[index * n->blocks] );
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Myers' bit-vector algorithm (as extended to edit distance by Hyyrö).
+ * Instead of a column of distances it keeps the vertical differences (+1/-1) between neighbouring
+ * cells of the column as two bit-masks, so a whole column of up to 64 needle characters is updated
+ * with a handful of word operations per haystack character. Longer needles are split in blocks,
+ * passing the horizontal difference at the block boundary on to the next block.
+ */
+static inline unsigned int levenshtein_needle_distance_real ( const LevenshteinNeedle *n, const char *haystack, glong haystacklen, gboolean folded )
+{
+    if ( n->len == 0 ) {
+        return haystacklen;
+    }
+    const glong   blocks = n->blocks;
+    const guint64 last   = G_GUINT64_CONSTANT ( 1 ) << ( ( n->len - 1 ) % LEVENSHTEIN_BLOCK_BITS );
+    unsigned int  score  = n->len;
+    if ( blocks == 1 ) {
+        guint64 pv = ~G_GUINT64_CONSTANT ( 0 ), mv = 0;
+        for ( glong x = 0; x < haystacklen; x++ ) {
+            const guint64 *peq = levenshtein_needle_peq ( n, &haystack, folded );
+            guint64       eq   = peq ? peq[0] : 0;
+            guint64       xv   = eq | mv;
+            guint64       xh   = ( ( ( eq & pv ) + pv ) ^ pv ) | eq;
+            guint64       ph   = mv | ~( xh | pv );
+            guint64       mh   = pv & xh;
+            if ( ph & last ) {
+                score++;
+            }
+            else if ( mh & last ) {
+                score--;
+            }
+            // First row of the matrix is 0,1,2..., so it always increments.
+            ph = ( ph << 1 ) | 1;
+            mh = mh << 1;
+            pv = mh | ~( xv | ph );
+            mv = ph & xv;
+        }
+        return score;
+    }
+
+    guint64 pv[blocks], mv[blocks];
+    for ( glong b = 0; b < blocks; b++ ) {
+        pv[b] = ~G_GUINT64_CONSTANT ( 0 );
+        mv[b] = 0;
+    }
+    for ( glong x = 0; x < haystacklen; x++ ) {
+        const guint64 *peq = levenshtein_needle_peq ( n, &haystack, folded );
+        // Horizontal difference entering the top of the block.
+        int           hin = 1;
+        for ( glong b = 0; b < blocks; b++ ) {
+            guint64 eq   = peq ? peq[b] : 0;
+            guint64 xv   = eq | mv[b];
+            guint64 high = ( b == ( blocks - 1 ) ) ? last : LEVENSHTEIN_HIGH_BIT;
+            if ( hin < 0 ) {
+                eq |= 1;
+            }
+            guint64 xh   = ( ( ( eq & pv[b] ) + pv[b] ) ^ pv[b] ) | eq;
+            guint64 ph   = mv[b] | ~( xh | pv[b] );
+            guint64 mh   = pv[b] & xh;
+            int     hout = ( ph & high ) ? 1 : ( ( mh & high ) ? -1 : 0 );
+            ph <<= 1;
+            mh <<= 1;
+            if ( hin < 0 ) {
+                mh |= 1;
+            }
+            else if ( hin > 0 ) {
+                ph |= 1;
+            }
+            pv[b] = mh | ~( xv | ph );
+            mv[b] = ph & xv;
+            hin   = hout;
+        }
+        score += hin;
+    }
+    return score;
+}
+
+unsigned int levenshtein_needle_distance ( const LevenshteinNeedle *n, const char *haystack, glong haystacklen )
+{
+    return levenshtein_needle_distance_real ( n, haystack, haystacklen, FALSE );
+}
+
+unsigned int levenshtein_needle_distance_folded ( const LevenshteinNeedle *n, const char *folded, glong haystacklen )
+{
+    return levenshtein_needle_distance_real ( n, folded, haystacklen, TRUE );
+}
 
 unsigned int levenshtein ( const char *needle, const glong needlelen, const char *haystack, const glong haystacklen )
 {
@@ -683,30 +1508,10 @@ unsigned int levenshtein ( const char *needle, const glong needlelen, const char
         // String to long, we cannot handle this.
         return UINT_MAX;
     }
-    unsigned int column[needlelen + 1];
-    for ( glong y = 0; y <= needlelen; y++ ) {
-        column[y] = y;
-    }
-    for ( glong x = 1; x <= haystacklen; x++ ) {
-        const char *needles = needle;
-        column[0] = x;
-        gunichar   haystackc = g_utf8_get_char ( haystack );
-        if ( !config.case_sensitive ) {
-            haystackc = g_unichar_tolower ( haystackc );
-        }
-        for ( glong y = 1, lastdiag = x - 1; y <= needlelen; y++ ) {
-            gunichar needlec = g_utf8_get_char ( needles );
-            if ( !config.case_sensitive ) {
-                needlec = g_unichar_tolower ( needlec );
-            }
-            unsigned int olddiag = column[y];
-            column[y] = MIN3 ( column[y] + 1, column[y - 1] + 1, lastdiag + ( needlec == haystackc ? 0 : 1 ) );
-            lastdiag  = olddiag;
-            needles   = g_utf8_next_char ( needles );
-        }
-        haystack = g_utf8_next_char ( haystack );
-    }
-    return column[needlelen];
+    LevenshteinNeedle *n    = levenshtein_needle_new ( needle, needlelen, config.case_sensitive );
+    unsigned int      retv = levenshtein_needle_distance ( n, haystack, haystacklen );
+    levenshtein_needle_free ( n );
+    return retv;
 }
 
 char * rofi_latin_to_utf8_strdup ( const char *input, gssize length )
@@ -748,7 +1553,7 @@ char * rofi_force_utf8 ( const gchar *data, ssize_t length )
  * FZF like scorer
  */
 
-/** Max length of input to score. */
+/** Max length of the part of the input that is scored exactly. */
 #define FUZZY_SCORER_MAX_LENGTH         256
 /** minimum score */
 #define MIN_SCORE                       ( INT_MIN / 2 )
@@ -827,12 +1632,172 @@ static int rofi_scorer_get_score_for ( enum CharClass prev, enum CharClass curr
 }
 
 /**
- * @param pattern   The user input to match against.
- * @param plen      Pattern length.
- * @param str       The input to match against pattern.
- * @param slen      Lenght of str.
+ * Scratch buffers of the scorer, one set per thread.
+ */
+typedef struct
+{
+    /** Number of entries the str buffers can hold. */
+    glong    ssize;
+    /** (Folded) characters of str. */
+    gunichar *sc;
+    /** Score of each position in str for the first character of a word in the pattern. */
+    int      *tstart;
+    /** Score of each position in str for the other characters in the pattern. */
+    int      *tnon;
+    /** Previous DP row, prefixed with one cell that is always #MIN_SCORE. */
+    int      *prev;
+    /** Current DP row, prefixed with one cell that is always #MIN_SCORE. */
+    int      *cur;
+    /** Maximum value of the cells on the left of each cell in the previous row, including gaps. */
+    int      *lefts;
+    /** Number of entries the pattern buffer can hold. */
+    glong    psize;
+    /** (Folded) characters of pattern. */
+    gunichar *pc;
+} RofiScorerScratch;
+
+static void rofi_scorer_scratch_free ( gpointer data )
+{
+    RofiScorerScratch *scratch = (RofiScorerScratch *) data;
+    g_free ( scratch->sc );
+    g_free ( scratch->tstart );
+    g_free ( scratch->tnon );
+    g_free ( scratch->prev );
+    g_free ( scratch->cur );
+    g_free ( scratch->lefts );
+    g_free ( scratch->pc );
+    g_free ( scratch );
+}
+
+/** Scorer scratch buffers of this thread, freed when the thread exits. */
+static GPrivate rofi_scorer_scratch_key = G_PRIVATE_INIT ( rofi_scorer_scratch_free );
+
+/**
+ * @param slen Number of characters in str.
+ * @param plen Number of characters in pattern.
+ *
+ * The buffers only grow, so workers that score many rows only allocate a few times.
+ *
+ * @returns the scratch buffers of this thread, large enough to score str against pattern.
+ */
+static RofiScorerScratch *rofi_scorer_get_scratch ( glong slen, glong plen )
+{
+    RofiScorerScratch *scratch = g_private_get ( &rofi_scorer_scratch_key );
+    if ( scratch == NULL ) {
+        scratch = g_malloc0 ( sizeof ( RofiScorerScratch ) );
+        g_private_set ( &rofi_scorer_scratch_key, scratch );
+    }
+    if ( scratch->ssize < slen ) {
+        scratch->ssize  = MAX ( slen, 2 * scratch->ssize );
+        scratch->sc     = g_realloc_n ( scratch->sc, scratch->ssize, sizeof ( gunichar ) );
+        scratch->tstart = g_realloc_n ( scratch->tstart, scratch->ssize, sizeof ( int ) );
+        scratch->tnon   = g_realloc_n ( scratch->tnon, scratch->ssize, sizeof ( int ) );
+        // Rows only cover the scored window.
+        glong rsize = MIN ( scratch->ssize, FUZZY_SCORER_MAX_LENGTH ) + 1;
+        scratch->prev  = g_realloc_n ( scratch->prev, rsize, sizeof ( int ) );
+        scratch->cur   = g_realloc_n ( scratch->cur, rsize, sizeof ( int ) );
+        scratch->lefts = g_realloc_n ( scratch->lefts, rsize, sizeof ( int ) );
+    }
+    if ( scratch->psize < plen ) {
+        scratch->psize = MAX ( plen, 2 * scratch->psize );
+        scratch->pc    = g_realloc_n ( scratch->pc, scratch->psize, sizeof ( gunichar ) );
+    }
+    return scratch;
+}
+
+#ifdef __SSE2__
+static inline __m128i rofi_scorer_sse2_max ( __m128i a, __m128i b )
+{
+    __m128i gt = _mm_cmpgt_epi32 ( a, b );
+    return _mm_or_si128 ( _mm_and_si128 ( gt, a ), _mm_andnot_si128 ( gt, b ) );
+}
+#endif
+
+/**
+ * @param cur   The row to fill in.
+ * @param diag  The previous row, shifted one to the left. (the upper left cells)
+ * @param lefts Maximum value on the left of each cell in the previous row.
+ * @param t     Score for matching at each position.
+ * @param sc    The characters of str.
+ * @param c     The character of pattern of this row.
+ * @param w     Number of cells.
  *
- *  rofi_scorer_fuzzy_evaluate implements a global sequence alignment algorithm to find the maximum accumulated score by
+ * The part of the DP row update without the dependency between neighbouring cells,
+ * so it can be done on 4 cells at once.
+ * cur[i] = sc[i] == c ? max ( diag[i] + CONSECUTIVE_SCORE, lefts[i] + t[i] ) : MIN_SCORE
+ */
+static void rofi_scorer_row_update ( int *cur, const int *diag, const int *lefts, const int *t, const gunichar *sc, gunichar c, glong w )
+{
+    glong i = 0;
+#ifdef __SSE2__
+    const __m128i vc    = _mm_set1_epi32 ( c );
+    const __m128i vcons = _mm_set1_epi32 ( CONSECUTIVE_SCORE );
+    const __m128i vmin  = _mm_set1_epi32 ( MIN_SCORE );
+    for (; ( i + 4 ) <= w; i += 4 ) {
+        __m128i d    = _mm_add_epi32 ( _mm_loadu_si128 ( (const __m128i *) &diag[i] ), vcons );
+        __m128i l    = _mm_add_epi32 ( _mm_loadu_si128 ( (const __m128i *) &lefts[i] ), _mm_loadu_si128 ( (const __m128i *) &t[i] ) );
+        __m128i best = rofi_scorer_sse2_max ( d, l );
+        __m128i eq   = _mm_cmpeq_epi32 ( _mm_loadu_si128 ( (const __m128i *) &sc[i] ), vc );
+        _mm_storeu_si128 ( (__m128i *) &cur[i], _mm_or_si128 ( _mm_and_si128 ( eq, best ), _mm_andnot_si128 ( eq, vmin ) ) );
+    }
+#endif
+    for (; i < w; i++ ) {
+        cur[i] = ( sc[i] == c ) ? MAX ( diag[i] + CONSECUTIVE_SCORE, lefts[i] + t[i] ) : MIN_SCORE;
+    }
+}
+
+/**
+ * @param pc     The (folded) pattern.
+ * @param plen   Pattern length.
+ * @param sc     The (folded) characters of str.
+ * @param tstart Score for each position when matching the start of a word in the pattern.
+ * @param tnon   Score for each position when matching other characters in the pattern.
+ * @param start  Position to start aligning.
+ * @param slen   Length of str.
+ *
+ * Score the leftmost alignment of pattern in str that starts at start, instead of the best alignment.
+ * This is a lower bound of the real score, used when the alignment does not fit #FUZZY_SCORER_MAX_LENGTH.
+ *
+ * @returns the score of the alignment.
+ */
+static int rofi_scorer_greedy_alignment ( const gunichar *pc, glong plen, const gunichar *sc, const int *tstart, const int *tnon, glong start, glong slen )
+{
+    gboolean pfirst = TRUE, pstart = TRUE;
+    glong    last   = start;
+    int      value  = 0;
+    for ( glong pi = 0, si = start; pi < plen; pi++ ) {
+        if ( g_unichar_isspace ( pc[pi] ) ) {
+            pstart = TRUE;
+            continue;
+        }
+        while ( sc[si] != pc[pi] ) {
+            si++;
+        }
+        int t = pstart ? tstart[si] : tnon[si];
+        if ( pfirst ) {
+            value = LEADING_GAP_SCORE * si + t;
+        }
+        else if ( si == last + 1 ) {
+            value = MAX ( value + CONSECUTIVE_SCORE, value + t );
+        }
+        else {
+            value = value + GAP_SCORE * ( si - last - 1 ) + t;
+        }
+        last   = si++;
+        pfirst = pstart = FALSE;
+    }
+    return value + GAP_SCORE * ( slen - 1 - last );
+}
+
+/**
+ * @param pattern The user input to match against.
+ * @param plen    Pattern length.
+ * @param str     The input to match against pattern.
+ * @param folded  str case folded with the same byte offsets, or NULL.
+ * @param slen    Lenght of str.
+ * @param case_sensitive Whether case is significant.
+ *
+ *  rofi_scorer_evaluate implements a global sequence alignment algorithm to find the maximum accumulated score by
  *  aligning `pattern` to `str`. It applies when `pattern` is a subsequence of `str`.
  *
  *  Scoring criteria
@@ -851,69 +1816,153 @@ static int rofi_scorer_get_score_for ( enum CharClass prev, enum CharClass curr
  *  The first dimension can be suppressed since we do not need a matching scheme, which reduces the space complexity from
  *  O(N*M) to O(M)
  *
+ *  The folded characters are taken from folded when given. The character classes still come from str,
+ *  as folding loses the upper case letters.
+ *
  * @returns the sorting weight.
  */
-int rofi_scorer_fuzzy_evaluate ( const char *pattern, glong plen, const char *str, glong slen )
+static int rofi_scorer_evaluate ( const char *pattern, glong plen, const char *str, const char *folded, glong slen, int case_sensitive )
 {
-    if ( slen > FUZZY_SCORER_MAX_LENGTH ) {
-        return -MIN_SCORE;
-    }
-    glong    pi, si;
+    RofiScorerScratch *scratch = rofi_scorer_get_scratch ( slen, plen );
+    gunichar          *sc      = scratch->sc;
+    gunichar          *pc      = scratch->pc;
+    int               *tstart  = scratch->tstart;
+    int               *tnon    = scratch->tnon;
+    glong             pi, si;
     // whether we are aligning the first character of pattern
-    gboolean pfirst = TRUE;
+    gboolean          pfirst = TRUE;
     // whether the start of a word in pattern
-    gboolean pstart = TRUE;
-    // score for each position
-    int      *score = g_malloc_n ( slen, sizeof ( int ) );
-    // dp[i]: maximum value by aligning pattern[0..pi] to str[0..si]
-    int      *dp = g_malloc_n ( slen, sizeof ( int ) );
-    // uleft: value of the upper left cell; ulefts: maximum value of uleft and cells on the left. The arbitrary initial
-    // values suppress warnings.
-    int            uleft = 0, ulefts = 0, left, lefts;
-    const gchar    *pit = pattern, *sit;
-    enum CharClass prev = NON_WORD;
+    gboolean          pstart   = TRUE;
+    gboolean          caseless = !case_sensitive;
+    const gchar       *pit     = pattern, *sit;
+    enum CharClass    prev     = NON_WORD;
+    // Decode and classify str once.
     for ( si = 0, sit = str; si < slen; si++, sit = g_utf8_next_char ( sit ) ) {
-        enum CharClass cur = rofi_scorer_get_character_class ( g_utf8_get_char ( sit ) );
-        score[si] = rofi_scorer_get_score_for ( prev, cur );
-        prev      = cur;
-        dp[si]    = MIN_SCORE;
+        gunichar       c     = g_utf8_get_char ( sit );
+        enum CharClass cur   = rofi_scorer_get_character_class ( c );
+        int            score = rofi_scorer_get_score_for ( prev, cur );
+        tstart[si] = score * PATTERN_START_MULTIPLIER;
+        tnon[si]   = score * PATTERN_NON_START_MULTIPLIER;
+        prev       = cur;
+        if ( !caseless ) {
+            sc[si] = c;
+        }
+        else if ( folded != NULL ) {
+            const char *fit = folded + ( sit - str );
+            sc[si] = ( *fit & 0x80 ) ? g_utf8_get_char ( fit ) : (gunichar) *fit;
+        }
+        else {
+            sc[si] = rofi_fold_char ( c );
+        }
     }
     for ( pi = 0; pi < plen; pi++, pit = g_utf8_next_char ( pit ) ) {
-        gunichar pc = g_utf8_get_char ( pit ), sc;
-        if ( g_unichar_isspace ( pc ) ) {
+        pc[pi] = g_utf8_get_char ( pit );
+        if ( caseless && !g_unichar_isspace ( pc[pi] ) ) {
+            pc[pi] = rofi_fold_char ( pc[pi] );
+        }
+    }
+    // Linear subsequence pass, the same the fuzzy matcher does. If pattern is not a subsequence of a line of str
+    // there is no alignment. Otherwise it can only be between the first occurrence of the first character on that
+    // line and the last occurrence of the last character of pattern, limit the alignment to that window.
+    glong start = -1, end = 0, last = -1;
+    for ( pi = 0, si = 0; si < slen; si++ ) {
+        while ( pi < plen && g_unichar_isspace ( pc[pi] ) ) {
+            pi++;
+        }
+        if ( pi == plen ) {
+            break;
+        }
+        if ( sc[si] == pc[pi] ) {
+            if ( start < 0 ) {
+                start = si;
+            }
+            last = pi++;
+        }
+        else if ( sc[si] == '\n' ) {
+            pi    = 0;
+            start = -1;
+        }
+    }
+    while ( pi < plen && g_unichar_isspace ( pc[pi] ) ) {
+        pi++;
+    }
+    if ( start < 0 || pi < plen ) {
+        return -MIN_SCORE;
+    }
+    for ( end = slen; sc[end - 1] != pc[last]; end-- ) {
+        ;
+    }
+    if ( ( end - start ) > FUZZY_SCORER_MAX_LENGTH ) {
+        // Window too large to score exactly. Find the shortest alignment ending where the leftmost one
+        // ends, by matching backwards from there, and score the window starting at it.
+        glong first = si;
+        for ( pi = plen - 1; pi >= 0; pi-- ) {
+            if ( g_unichar_isspace ( pc[pi] ) ) {
+                continue;
+            }
+            do {
+                first--;
+            } while ( sc[first] != pc[pi] );
+        }
+        if ( ( si - first ) > FUZZY_SCORER_MAX_LENGTH ) {
+            // Even that does not fit, score the alignment itself.
+            return -rofi_scorer_greedy_alignment ( pc, plen, sc, tstart, tnon, first, slen );
+        }
+        start = first;
+        end   = MIN ( end, start + FUZZY_SCORER_MAX_LENGTH );
+    }
+
+    // Rows are relative to start, and have an extra cell in front so the upper left cell always exists.
+    const glong w       = end - start;
+    int         *dp     = scratch->prev;
+    int         *next   = scratch->cur;
+    int         *ulefts = scratch->lefts;
+    int         lefts;
+    dp[0] = next[0] = MIN_SCORE;
+    for ( pi = 0; pi < plen; pi++ ) {
+        if ( g_unichar_isspace ( pc[pi] ) ) {
             pstart = TRUE;
             continue;
         }
-        lefts = MIN_SCORE;
-        for ( si = 0, sit = str; si < slen; si++, sit = g_utf8_next_char ( sit ) ) {
-            left  = dp[si];
-            lefts = MAX ( lefts + GAP_SCORE, left );
-            sc    = g_utf8_get_char ( sit );
-            if ( config.case_sensitive
-                 ? pc == sc
-                 : g_unichar_tolower ( pc ) == g_unichar_tolower ( sc ) ) {
-                int t = score[si] * ( pstart ? PATTERN_START_MULTIPLIER : PATTERN_NON_START_MULTIPLIER );
-                dp[si] = pfirst
-                         ? LEADING_GAP_SCORE * si + t
-                         : MAX ( uleft + CONSECUTIVE_SCORE, ulefts + t );
+        const int *t = ( pstart ? tstart : tnon ) + start;
+        if ( pfirst ) {
+            for ( si = 0; si < w; si++ ) {
+                dp[si + 1] = ( sc[start + si] == pc[pi] ) ? LEADING_GAP_SCORE * ( start + si ) + t[si] : MIN_SCORE;
             }
-            else {
-                dp[si] = MIN_SCORE;
+        }
+        else {
+            // The running maximum on the left depends on the previous cell, do it first.
+            lefts = MIN_SCORE;
+            for ( si = 0; si < w; si++ ) {
+                ulefts[si] = lefts;
+                lefts      = MAX ( lefts + GAP_SCORE, dp[si + 1] );
             }
-            uleft  = left;
-            ulefts = lefts;
+            rofi_scorer_row_update ( next + 1, dp, ulefts, t, sc + start, pc[pi], w );
+            int *swap = dp;
+            dp   = next;
+            next = swap;
         }
         pfirst = pstart = FALSE;
     }
     lefts = MIN_SCORE;
-    for ( si = 0; si < slen; si++ ) {
-        lefts = MAX ( lefts + GAP_SCORE, dp[si] );
+    for ( si = 0; si < w; si++ ) {
+        lefts = MAX ( lefts + GAP_SCORE, dp[si + 1] );
     }
-    g_free ( score );
-    g_free ( dp );
+    // Gap after the window.
+    lefts += GAP_SCORE * ( slen - end );
     return -lefts;
 }
 
+int rofi_scorer_fuzzy_evaluate ( const char *pattern, glong plen, const char *str, glong slen, int case_sensitive )
+{
+    return rofi_scorer_evaluate ( pattern, plen, str, NULL, slen, case_sensitive );
+}
+
+int rofi_scorer_fuzzy_evaluate_folded ( const char *pattern, glong plen, const char *str, const char *folded, glong slen, int case_sensitive )
+{
+    return rofi_scorer_evaluate ( pattern, plen, str, folded, slen, case_sensitive );
+}
+
 /**
  * @param a    UTF-8 string to compare
  * @param b    UTF-8 string to compare
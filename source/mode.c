@@ -31,6 +31,7 @@
 #include "rofi.h"
 #include "xrmoptions.h"
 #include "x11-helper.h"
+#include "helper.h"
 #include "mode.h"
 
 // This one should only be in mode implementations.
@@ -83,6 +84,21 @@ char * mode_get_completion ( const Mode *mode, unsigned int selected_line )
     }
 }
 
+const char * mode_get_match_string ( const Mode *mode, unsigned int selected_line, unsigned int field, glong *length )
+{
+    g_assert ( mode != NULL );
+    g_assert ( length != NULL );
+    if ( mode->_get_match_string == NULL ) {
+        return NULL;
+    }
+    *length = -1;
+    const char *str = mode->_get_match_string ( mode, selected_line, field, length );
+    if ( str != NULL && *length < 0 ) {
+        *length = g_utf8_strlen ( str, -1 );
+    }
+    return str;
+}
+
 ModeMode mode_result ( Mode *mode, int menu_retv, char **input, unsigned int selected_line )
 {
     g_assert ( mode != NULL );
@@ -91,13 +107,28 @@ ModeMode mode_result ( Mode *mode, int menu_retv, char **input, unsigned int sel
     return mode->_result ( mode, menu_retv, input, selected_line );
 }
 
-int mode_token_match ( const Mode *mode, GRegex **tokens, unsigned int selected_line )
+int mode_token_match ( const Mode *mode, rofi_int_matcher **tokens, unsigned int selected_line )
 {
     g_assert ( mode != NULL );
     g_assert ( mode->_token_match != NULL );
     return mode->_token_match ( mode, tokens, selected_line );
 }
 
+void mode_token_match_range ( const Mode *mode, rofi_int_matcher **tokens, unsigned int start, unsigned int stop, guint32 *matches )
+{
+    g_assert ( mode != NULL );
+    g_assert ( start <= stop );
+    if ( mode->_token_match_range != NULL ) {
+        mode->_token_match_range ( mode, tokens, start, stop, matches );
+        return;
+    }
+    for ( unsigned int i = start; i < stop; i++ ) {
+        if ( mode_token_match ( mode, tokens, i ) ) {
+            helper_match_bitmap_set ( matches, i - start );
+        }
+    }
+}
+
 const char *mode_get_name ( const Mode *mode )
 {
     g_assert ( mode != NULL );
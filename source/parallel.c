@@ -0,0 +1,249 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/** The log domain of this module. */
+#define G_LOG_DOMAIN    "Parallel"
+
+#include <config.h>
+#include <glib.h>
+#include "parallel.h"
+
+/**
+ * Number of chunks to cut a range in per worker.
+ * More chunks balance better, but each chunk costs a lock and a callback.
+ */
+#define PARALLEL_CHUNKS_PER_WORKER    8
+
+/**
+ * The chunks a worker still has to run, [head, tail).
+ * The owner takes chunks from the head, thieves from the tail.
+ */
+typedef struct
+{
+    GMutex       lock;
+    unsigned int head;
+    unsigned int tail;
+} ParallelQueue;
+
+/**
+ * One rofi_parallel_for() call, shared by all workers.
+ * The last worker to drop its reference frees it, so helpers that start late
+ * (when the pool is busy) never touch freed memory and the caller never waits on them.
+ */
+typedef struct
+{
+    RofiParallelRange range;
+    RofiParallelFunc  func;
+    gpointer          user_data;
+    /** Worker id handed to the next helper thread. */
+    gint              next_worker;
+    /** Chunks not yet finished. */
+    gint              chunks_left;
+    gint              ref_count;
+    GMutex            done_lock;
+    GCond             done_cond;
+    unsigned int      num_workers;
+    ParallelQueue     queues[];
+} ParallelJob;
+
+/** Pool with the helper threads, NULL when running single threaded. */
+static GThreadPool  *parallel_pool = NULL;
+/** Number of workers, including the calling thread. */
+static unsigned int parallel_workers = 1;
+
+static void parallel_job_unref ( ParallelJob *job )
+{
+    if ( g_atomic_int_dec_and_test ( &( job->ref_count ) ) ) {
+        for ( unsigned int i = 0; i < job->num_workers; i++ ) {
+            g_mutex_clear ( &( job->queues[i].lock ) );
+        }
+        g_mutex_clear ( &( job->done_lock ) );
+        g_cond_clear ( &( job->done_cond ) );
+        g_free ( job );
+    }
+}
+
+static gboolean parallel_queue_pop ( ParallelQueue *q, unsigned int *chunk )
+{
+    gboolean retv = FALSE;
+    g_mutex_lock ( &( q->lock ) );
+    if ( q->head < q->tail ) {
+        *chunk = q->head++;
+        retv   = TRUE;
+    }
+    g_mutex_unlock ( &( q->lock ) );
+    return retv;
+}
+
+/**
+ * Take half of the chunks of the worker with the most work left.
+ * The first stolen chunk is returned, the rest moves to the queue of the thief.
+ */
+static gboolean parallel_job_steal ( ParallelJob *job, unsigned int worker, unsigned int *chunk )
+{
+    while ( TRUE ) {
+        ParallelQueue *victim = NULL;
+        unsigned int  most    = 0;
+        for ( unsigned int i = 0; i < job->num_workers; i++ ) {
+            if ( i == worker ) {
+                continue;
+            }
+            ParallelQueue *q = &( job->queues[i] );
+            g_mutex_lock ( &( q->lock ) );
+            unsigned int  left = q->tail - q->head;
+            g_mutex_unlock ( &( q->lock ) );
+            if ( left > most ) {
+                most   = left;
+                victim = q;
+            }
+        }
+        if ( victim == NULL ) {
+            return FALSE;
+        }
+        unsigned int start = 0, stop = 0;
+        g_mutex_lock ( &( victim->lock ) );
+        if ( victim->head < victim->tail ) {
+            stop         = victim->tail;
+            start        = stop - ( stop - victim->head + 1 ) / 2;
+            victim->tail = start;
+        }
+        g_mutex_unlock ( &( victim->lock ) );
+        if ( start < stop ) {
+            ParallelQueue *own = &( job->queues[worker] );
+            g_mutex_lock ( &( own->lock ) );
+            own->head = start + 1;
+            own->tail = stop;
+            g_mutex_unlock ( &( own->lock ) );
+            *chunk = start;
+            return TRUE;
+        }
+        // Victim emptied its queue before we got to it, look again.
+    }
+}
+
+static void parallel_job_run ( ParallelJob *job, unsigned int worker )
+{
+    unsigned int chunk;
+    while ( parallel_queue_pop ( &( job->queues[worker] ), &chunk ) || parallel_job_steal ( job, worker, &chunk ) ) {
+        unsigned int start = chunk * job->range.chunk_size;
+        unsigned int stop  = MIN ( job->range.n, start + job->range.chunk_size );
+        job->func ( worker, chunk, start, stop, job->user_data );
+        if ( g_atomic_int_dec_and_test ( &( job->chunks_left ) ) ) {
+            g_mutex_lock ( &( job->done_lock ) );
+            g_cond_broadcast ( &( job->done_cond ) );
+            g_mutex_unlock ( &( job->done_lock ) );
+        }
+    }
+}
+
+static void parallel_pool_func ( gpointer data, G_GNUC_UNUSED gpointer user_data )
+{
+    ParallelJob  *job    = (ParallelJob *) data;
+    unsigned int worker = (unsigned int) g_atomic_int_add ( &( job->next_worker ), 1 );
+    parallel_job_run ( job, worker );
+    parallel_job_unref ( job );
+}
+
+gboolean rofi_parallel_init ( unsigned int workers, GError **error )
+{
+    parallel_workers = MAX ( workers, 1 );
+    if ( parallel_workers == 1 ) {
+        return TRUE;
+    }
+    // The calling thread is one of the workers.
+    parallel_pool = g_thread_pool_new ( parallel_pool_func, NULL, parallel_workers - 1, FALSE, error );
+    if ( parallel_pool == NULL ) {
+        parallel_workers = 1;
+        return FALSE;
+    }
+    // Idle threads should stick around for a max of 60 seconds.
+    g_thread_pool_set_max_idle_time ( 60000 );
+    return TRUE;
+}
+
+void rofi_parallel_cleanup ( void )
+{
+    if ( parallel_pool != NULL ) {
+        g_thread_pool_free ( parallel_pool, TRUE, TRUE );
+        parallel_pool = NULL;
+    }
+    parallel_workers = 1;
+}
+
+unsigned int rofi_parallel_num_workers ( void )
+{
+    return parallel_workers;
+}
+
+void rofi_parallel_range_init ( RofiParallelRange *range, unsigned int n, unsigned int min_chunk_size )
+{
+    unsigned int target = ( parallel_workers > 1 ) ? parallel_workers * PARALLEL_CHUNKS_PER_WORKER : 1;
+    unsigned int size   = n / target + ( ( n % target ) != 0 );
+    range->n          = n;
+    range->chunk_size = MAX ( MAX ( size, min_chunk_size ), 1 );
+    range->num_chunks = n / range->chunk_size + ( ( n % range->chunk_size ) != 0 );
+}
+
+void rofi_parallel_for ( const RofiParallelRange *range, RofiParallelFunc func, gpointer user_data )
+{
+    unsigned int workers = MIN ( parallel_workers, range->num_chunks );
+    if ( workers <= 1 || parallel_pool == NULL ) {
+        for ( unsigned int chunk = 0; chunk < range->num_chunks; chunk++ ) {
+            unsigned int start = chunk * range->chunk_size;
+            func ( 0, chunk, start, MIN ( range->n, start + range->chunk_size ), user_data );
+        }
+        return;
+    }
+
+    ParallelJob *job = g_malloc0 ( sizeof ( ParallelJob ) + workers * sizeof ( ParallelQueue ) );
+    job->range       = *range;
+    job->func        = func;
+    job->user_data   = user_data;
+    job->next_worker = 1;
+    job->chunks_left = range->num_chunks;
+    job->ref_count   = workers;
+    job->num_workers = workers;
+    g_mutex_init ( &( job->done_lock ) );
+    g_cond_init ( &( job->done_cond ) );
+    // Give each worker an equal, contiguous, share to start with.
+    for ( unsigned int i = 0; i < workers; i++ ) {
+        g_mutex_init ( &( job->queues[i].lock ) );
+        job->queues[i].head = (unsigned int) ( ( (guint64) range->num_chunks * i ) / workers );
+        job->queues[i].tail = (unsigned int) ( ( (guint64) range->num_chunks * ( i + 1 ) ) / workers );
+    }
+    for ( unsigned int i = 1; i < workers; i++ ) {
+        g_thread_pool_push ( parallel_pool, job, NULL );
+    }
+    parallel_job_run ( job, 0 );
+
+    g_mutex_lock ( &( job->done_lock ) );
+    while ( g_atomic_int_get ( &( job->chunks_left ) ) > 0 ) {
+        g_cond_wait ( &( job->done_cond ), &( job->done_lock ) );
+    }
+    g_mutex_unlock ( &( job->done_lock ) );
+    parallel_job_unref ( job );
+}
@@ -476,6 +476,7 @@ static void cleanup ()
 
     // Cleanup the custom keybinding
     cleanup_abe ();
+    tokenize_cache_clear ();
 
     g_free ( config_path );
 
@@ -0,0 +1,463 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+/** The log domain of this module. */
+#define G_LOG_DOMAIN    "Sort"
+
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+#include "parallel.h"
+#include "sort.h"
+
+/** Ranges of this size and smaller are finished with an insertion sort. */
+#define SORT_INSERTION_LIMIT       16
+/** Below this many rows a comparison sort is cheaper than a radix sort. */
+#define SORT_RADIX_MIN             1024
+/** Number of key bits sorted on in one radix pass. */
+#define SORT_RADIX_BITS            11
+/** Number of buckets of one radix pass. */
+#define SORT_RADIX_BUCKETS         ( 1 << SORT_RADIX_BITS )
+/** Smallest number of rows worth handing to another worker. */
+#define SORT_PARALLEL_MIN_CHUNK    16384
+
+/**
+ * State of a radix sort, shared by the workers.
+ * The range is cut in the same chunks for each pass, so each chunk can count
+ * its own rows and write them to its own part of each bucket.
+ */
+typedef struct
+{
+    const int          *distance;
+    unsigned int       *rows;
+    /** Keys are read from src and written to dst, these swap after each pass. */
+    guint64            *src;
+    guint64            *dst;
+    RofiParallelRange  range;
+    /** The key bits sorted on in this pass. */
+    unsigned int       shift;
+    /** Per chunk the rows in each bucket, then the offset to write the next one, [chunk][bucket]. */
+    unsigned int       *counts;
+    /** Per chunk the key bits that differ from the first key. */
+    guint64            *diff;
+} SortRadix;
+
+static inline gboolean sort_less ( const int *distance, unsigned int a, unsigned int b )
+{
+    return distance[a] < distance[b] || ( distance[a] == distance[b] && a < b );
+}
+
+static int sort_compare ( gconstpointer p1, gconstpointer p2, gpointer data )
+{
+    const unsigned int *a        = p1;
+    const unsigned int *b        = p2;
+    const int          *distance = data;
+    return sort_less ( distance, *b, *a ) - sort_less ( distance, *a, *b );
+}
+
+static inline void sort_swap ( unsigned int *rows, unsigned int a, unsigned int b )
+{
+    unsigned int tmp = rows[a];
+    rows[a] = rows[b];
+    rows[b] = tmp;
+}
+
+static void sort_insertion ( unsigned int *rows, unsigned int n, const int *distance )
+{
+    for ( unsigned int i = 1; i < n; i++ ) {
+        unsigned int row = rows[i];
+        unsigned int j   = i;
+        for (; j > 0 && sort_less ( distance, row, rows[j - 1] ); j-- ) {
+            rows[j] = rows[j - 1];
+        }
+        rows[j] = row;
+    }
+}
+
+/**
+ * Quickselect: partition rows so that the first k rows come before all others.
+ * The pivot is the median of three, and when partitioning goes badly too often the
+ * remaining range is sorted instead, so the worst case stays O(n log n).
+ */
+static void sort_select ( unsigned int *rows, unsigned int n, unsigned int k, const int *distance, gboolean split )
+{
+    unsigned int lo    = 0;
+    unsigned int hi    = n;
+    unsigned int depth = 2 * g_bit_storage ( n );
+    while ( hi - lo > SORT_INSERTION_LIMIT ) {
+        if ( depth-- == 0 ) {
+            if ( split ) {
+                rofi_sort_rows ( &( rows[lo] ), hi - lo, distance );
+            }
+            else {
+                rofi_sort_rows_serial ( &( rows[lo] ), hi - lo, distance );
+            }
+            return;
+        }
+        // Order first, middle and last, the middle one is the pivot.
+        unsigned int mid = lo + ( hi - lo - 1 ) / 2;
+        if ( sort_less ( distance, rows[mid], rows[lo] ) ) {
+            sort_swap ( rows, mid, lo );
+        }
+        if ( sort_less ( distance, rows[hi - 1], rows[mid] ) ) {
+            sort_swap ( rows, hi - 1, mid );
+            if ( sort_less ( distance, rows[mid], rows[lo] ) ) {
+                sort_swap ( rows, mid, lo );
+            }
+        }
+        unsigned int pivot = rows[mid];
+        // Hoare partition, all rows are distinct so this always makes progress.
+        unsigned int i = lo, j = hi - 1;
+        while ( TRUE ) {
+            while ( sort_less ( distance, rows[i], pivot ) ) {
+                i++;
+            }
+            while ( sort_less ( distance, pivot, rows[j] ) ) {
+                j--;
+            }
+            if ( i >= j ) {
+                break;
+            }
+            sort_swap ( rows, i, j );
+            i++;
+            j--;
+        }
+        // [lo, j] comes before [j + 1, hi).
+        if ( k == j + 1 ) {
+            return;
+        }
+        if ( k <= j ) {
+            hi = j + 1;
+        }
+        else {
+            lo = j + 1;
+        }
+    }
+    sort_insertion ( &( rows[lo] ), hi - lo, distance );
+}
+
+/**
+ * The sort key of a row: the distance, made unsigned so the order is kept, in the high half,
+ * the row index in the low half. Sorting these as numbers gives the row order.
+ */
+static inline guint64 sort_key ( const int *distance, unsigned int row )
+{
+    return ( ( (guint64) ( ( (guint32) distance[row] ) ^ 0x80000000u ) ) << 32 ) | row;
+}
+
+static void sort_radix_keys ( G_GNUC_UNUSED unsigned int worker, unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data )
+{
+    SortRadix *r    = (SortRadix *) user_data;
+    guint64   first = sort_key ( r->distance, r->rows[0] );
+    guint64   diff  = 0;
+    for ( unsigned int i = start; i < stop; i++ ) {
+        r->src[i] = sort_key ( r->distance, r->rows[i] );
+        diff     |= r->src[i] ^ first;
+    }
+    r->diff[chunk] = diff;
+}
+
+static void sort_radix_count ( G_GNUC_UNUSED unsigned int worker, unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data )
+{
+    SortRadix    *r      = (SortRadix *) user_data;
+    unsigned int *counts = &( r->counts[chunk * SORT_RADIX_BUCKETS] );
+    memset ( counts, 0, SORT_RADIX_BUCKETS * sizeof ( unsigned int ) );
+    for ( unsigned int i = start; i < stop; i++ ) {
+        counts[( r->src[i] >> r->shift ) & ( SORT_RADIX_BUCKETS - 1 )]++;
+    }
+}
+
+static void sort_radix_scatter ( G_GNUC_UNUSED unsigned int worker, unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data )
+{
+    SortRadix    *r       = (SortRadix *) user_data;
+    unsigned int *offsets = &( r->counts[chunk * SORT_RADIX_BUCKETS] );
+    for ( unsigned int i = start; i < stop; i++ ) {
+        r->dst[offsets[( r->src[i] >> r->shift ) & ( SORT_RADIX_BUCKETS - 1 )]++] = r->src[i];
+    }
+}
+
+/**
+ * LSD radix sort on the 64 bit keys. Passes over bits that are the same for all keys are skipped,
+ * for the usual small distances and row counts that leaves two to four passes.
+ * When split is set, counting and moving the keys of each pass is split over the workers.
+ */
+static void sort_radix ( unsigned int *rows, unsigned int n, const int *distance, gboolean split )
+{
+    SortRadix r = {
+        .distance = distance,
+        .rows     = rows,
+        .src      = g_malloc_n ( n, sizeof ( guint64 ) ),
+        .dst      = g_malloc_n ( n, sizeof ( guint64 ) ),
+    };
+    if ( split ) {
+        rofi_parallel_range_init ( &( r.range ), n, SORT_PARALLEL_MIN_CHUNK );
+    }
+    else {
+        // One chunk, rofi_parallel_for() runs it in this thread.
+        r.range.n          = n;
+        r.range.chunk_size = n;
+        r.range.num_chunks = 1;
+    }
+    r.counts = g_malloc_n ( r.range.num_chunks * SORT_RADIX_BUCKETS, sizeof ( unsigned int ) );
+    r.diff   = g_malloc0_n ( r.range.num_chunks, sizeof ( guint64 ) );
+
+    rofi_parallel_for ( &( r.range ), sort_radix_keys, &r );
+    guint64 diff = 0;
+    for ( unsigned int c = 0; c < r.range.num_chunks; c++ ) {
+        diff |= r.diff[c];
+    }
+    for ( r.shift = 0; r.shift < 64; r.shift += SORT_RADIX_BITS ) {
+        if ( ( ( diff >> r.shift ) & ( SORT_RADIX_BUCKETS - 1 ) ) == 0 ) {
+            continue;
+        }
+        rofi_parallel_for ( &( r.range ), sort_radix_count, &r );
+        // Turn the counts in write offsets: bucket by bucket, and within a bucket chunk by chunk.
+        unsigned int offset = 0;
+        for ( unsigned int b = 0; b < SORT_RADIX_BUCKETS; b++ ) {
+            for ( unsigned int c = 0; c < r.range.num_chunks; c++ ) {
+                unsigned int count = r.counts[c * SORT_RADIX_BUCKETS + b];
+                r.counts[c * SORT_RADIX_BUCKETS + b] = offset;
+                offset                              += count;
+            }
+        }
+        rofi_parallel_for ( &( r.range ), sort_radix_scatter, &r );
+        guint64 *tmp = r.src;
+        r.src = r.dst;
+        r.dst = tmp;
+    }
+    for ( unsigned int i = 0; i < n; i++ ) {
+        rows[i] = (unsigned int) r.src[i];
+    }
+    g_free ( r.diff );
+    g_free ( r.counts );
+    g_free ( r.dst );
+    g_free ( r.src );
+}
+
+void rofi_sort_rows ( unsigned int *rows, unsigned int n, const int *distance )
+{
+    if ( n < SORT_RADIX_MIN ) {
+        g_qsort_with_data ( rows, n, sizeof ( unsigned int ), sort_compare, (gpointer) distance );
+    }
+    else {
+        sort_radix ( rows, n, distance, TRUE );
+    }
+}
+
+void rofi_sort_rows_serial ( unsigned int *rows, unsigned int n, const int *distance )
+{
+    if ( n < SORT_RADIX_MIN ) {
+        g_qsort_with_data ( rows, n, sizeof ( unsigned int ), sort_compare, (gpointer) distance );
+    }
+    else {
+        sort_radix ( rows, n, distance, FALSE );
+    }
+}
+
+void rofi_sort_partial ( unsigned int *rows, unsigned int n, unsigned int k, const int *distance )
+{
+    // When most rows are asked for, selecting them first does not pay off.
+    if ( k >= n / 2 ) {
+        rofi_sort_rows ( rows, n, distance );
+        return;
+    }
+    sort_select ( rows, n, k, distance, TRUE );
+    rofi_sort_rows ( rows, k, distance );
+}
+
+void rofi_sort_partial_serial ( unsigned int *rows, unsigned int n, unsigned int k, const int *distance )
+{
+    if ( k >= n / 2 ) {
+        rofi_sort_rows_serial ( rows, n, distance );
+        return;
+    }
+    sort_select ( rows, n, k, distance, FALSE );
+    rofi_sort_rows_serial ( rows, k, distance );
+}
+
+unsigned int rofi_sort_append ( unsigned int *rows, unsigned int n, unsigned int sorted, unsigned int m, unsigned int m_sorted, const int *distance )
+{
+    const unsigned int *a     = rows;
+    const unsigned int *b     = &( rows[n] );
+    unsigned int       total  = sorted + m_sorted;
+    unsigned int       *tmp   = g_malloc_n ( total + 1, sizeof ( unsigned int ) );
+    unsigned int       i      = 0, j = 0, k = 0;
+    // A sorted part that still has unsorted rows behind it cannot run out, the next row could be one of those.
+    while ( ( i < sorted || sorted == n ) && ( j < m_sorted || m_sorted == m ) && ( i < sorted || j < m_sorted ) ) {
+        if ( j == m_sorted || ( i < sorted && sort_less ( distance, a[i], b[j] ) ) ) {
+            tmp[k++] = a[i++];
+        }
+        else {
+            tmp[k++] = b[j++];
+        }
+    }
+    unsigned int in_order = k;
+    // The rest of the sorted parts still comes before the unsorted rows.
+    memcpy ( &( tmp[k] ), &( a[i] ), ( sorted - i ) * sizeof ( unsigned int ) );
+    k += sorted - i;
+    memcpy ( &( tmp[k] ), &( b[j] ), ( m_sorted - j ) * sizeof ( unsigned int ) );
+    // Move the unsorted rows of the list that are in the way to where the sorted appended rows were.
+    unsigned int moved = MIN ( n - sorted, m_sorted );
+    memmove ( &( rows[n + m_sorted - moved] ), &( rows[sorted] ), moved * sizeof ( unsigned int ) );
+    memcpy ( rows, tmp, total * sizeof ( unsigned int ) );
+    g_free ( tmp );
+    return in_order;
+}
+
+/**
+ * State of a merge, shared by the workers.
+ * The output is cut in chunks, each worker merges the part of every run that lands in its chunk.
+ */
+typedef struct
+{
+    unsigned int       *dst;
+    const unsigned int *src;
+    const unsigned int *run_start;
+    const unsigned int *run_length;
+    unsigned int       num_runs;
+    const int          *distance;
+} SortMerge;
+
+/**
+ * Count the rows with a key below key, in split the count of each run (if not NULL).
+ */
+static unsigned int sort_merge_count ( const SortMerge *m, guint64 key, unsigned int *split )
+{
+    unsigned int total = 0;
+    for ( unsigned int r = 0; r < m->num_runs; r++ ) {
+        const unsigned int *run = &( m->src[m->run_start[r]] );
+        unsigned int       a    = 0, b = m->run_length[r];
+        while ( a < b ) {
+            unsigned int mid = a + ( b - a ) / 2;
+            if ( sort_key ( m->distance, run[mid] ) < key ) {
+                a = mid + 1;
+            }
+            else {
+                b = mid;
+            }
+        }
+        if ( split != NULL ) {
+            split[r] = a;
+        }
+        total += a;
+    }
+    return total;
+}
+
+/**
+ * Find how many rows of each run are among the first rank rows of the result.
+ * Keys are unique, so there is a key with exactly rank keys below it, search for it.
+ */
+static void sort_merge_split ( const SortMerge *m, unsigned int rank, unsigned int *split )
+{
+    guint64 lo = 0, hi = G_MAXUINT64;
+    while ( lo < hi ) {
+        guint64 mid = lo + ( hi - lo ) / 2 + 1;
+        if ( sort_merge_count ( m, mid, NULL ) <= rank ) {
+            lo = mid;
+        }
+        else {
+            hi = mid - 1;
+        }
+    }
+    sort_merge_count ( m, lo, split );
+}
+
+static inline gboolean sort_merge_less ( const SortMerge *m, const unsigned int *pos, unsigned int a, unsigned int b )
+{
+    return sort_less ( m->distance, m->src[m->run_start[a] + pos[a]], m->src[m->run_start[b] + pos[b]] );
+}
+
+static void sort_merge_sift_down ( const SortMerge *m, const unsigned int *pos, unsigned int *heap, unsigned int n, unsigned int i )
+{
+    while ( TRUE ) {
+        unsigned int least = i;
+        unsigned int left  = 2 * i + 1;
+        unsigned int right = left + 1;
+        if ( left < n && sort_merge_less ( m, pos, heap[left], heap[least] ) ) {
+            least = left;
+        }
+        if ( right < n && sort_merge_less ( m, pos, heap[right], heap[least] ) ) {
+            least = right;
+        }
+        if ( least == i ) {
+            return;
+        }
+        unsigned int tmp = heap[i];
+        heap[i]     = heap[least];
+        heap[least] = tmp;
+        i           = least;
+    }
+}
+
+static void sort_merge_chunk ( G_GNUC_UNUSED unsigned int worker, G_GNUC_UNUSED unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data )
+{
+    const SortMerge *m    = (const SortMerge *) user_data;
+    unsigned int    *pos  = g_malloc_n ( 3 * m->num_runs, sizeof ( unsigned int ) );
+    unsigned int    *end  = &( pos[m->num_runs] );
+    unsigned int    *heap = &( pos[2 * m->num_runs] );
+    unsigned int    n     = 0;
+    sort_merge_split ( m, start, pos );
+    sort_merge_split ( m, stop, end );
+    for ( unsigned int r = 0; r < m->num_runs; r++ ) {
+        if ( pos[r] < end[r] ) {
+            heap[n++] = r;
+        }
+    }
+    for ( unsigned int i = n / 2; i > 0; i-- ) {
+        sort_merge_sift_down ( m, pos, heap, n, i - 1 );
+    }
+    for ( unsigned int o = start; n > 0; o++ ) {
+        unsigned int r = heap[0];
+        m->dst[o] = m->src[m->run_start[r] + pos[r]];
+        if ( ++pos[r] == end[r] ) {
+            heap[0] = heap[--n];
+        }
+        sort_merge_sift_down ( m, pos, heap, n, 0 );
+    }
+    g_free ( pos );
+}
+
+void rofi_sort_merge ( unsigned int *dst, const unsigned int *src, const unsigned int *run_start, const unsigned int *run_length, unsigned int num_runs, const int *distance )
+{
+    SortMerge         m     = {
+        .dst        = dst,
+        .src        = src,
+        .run_start  = run_start,
+        .run_length = run_length,
+        .num_runs   = num_runs,
+        .distance   = distance,
+    };
+    unsigned int      total = 0;
+    RofiParallelRange range;
+    for ( unsigned int r = 0; r < num_runs; r++ ) {
+        total += run_length[r];
+    }
+    rofi_parallel_range_init ( &range, total, SORT_PARALLEL_MIN_CHUNK );
+    rofi_parallel_for ( &range, sort_merge_chunk, &m );
+}
@@ -0,0 +1,437 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+/** The log domain of this module. */
+#define G_LOG_DOMAIN    "Trigram"
+
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+#include "settings.h"
+#include "parallel.h"
+#include "trigram.h"
+
+/** Number of different bytes after folding: ASCII plus one for all bytes >= 0x80. */
+#define TRIGRAM_SYMBOLS           129
+/** Number of possible trigrams. */
+#define TRIGRAM_KEYS              ( TRIGRAM_SYMBOLS * TRIGRAM_SYMBOLS * TRIGRAM_SYMBOLS )
+/** Smallest number of rows (or trigrams) worth handing to another worker. */
+#define TRIGRAM_MIN_CHUNK_SIZE    1024
+/** Number of rows to index before looking if the build got cancelled. */
+#define TRIGRAM_CANCEL_CHECK      256
+
+struct _RofiTrigramIndex
+{
+    /** The trigrams that occur, ascending. */
+    guint32      *keys;
+    /** Number of trigrams that occur. */
+    unsigned int num_keys;
+    /** The rows containing keys[i] are rows[start[i]] up to rows[start[i + 1]]. */
+    unsigned int *start;
+    /** All posting lists, each in ascending row order. */
+    unsigned int *rows;
+    /** Rows without strings to index, ascending. They are candidates for every input. */
+    unsigned int *unindexed;
+    unsigned int num_unindexed;
+};
+
+/**
+ * State of building an index, shared by the workers.
+ */
+typedef struct
+{
+    RofiTrigramTextFunc func;
+    gpointer            user_data;
+    const gint          *cancel;
+    /** Per trigram the number of rows, then the next free place in its posting list. */
+    gint                *counts;
+    /** Per worker the trigrams of the current row. */
+    GArray              **scratch;
+    /** Number of rows without strings, then the next free place in the unindexed list. */
+    gint                num_unindexed;
+    RofiTrigramIndex    *index;
+} TrigramBuild;
+
+static inline gboolean trigram_build_cancelled ( const TrigramBuild *b )
+{
+    return b->cancel != NULL && g_atomic_int_get ( b->cancel );
+}
+
+static inline guint32 trigram_symbol ( unsigned char c )
+{
+    if ( c >= 0x80 ) {
+        return 128;
+    }
+    return ( c >= 'A' && c <= 'Z' ) ? ( c | 0x20 ) : c;
+}
+
+static int trigram_uint_compare ( gconstpointer p1, gconstpointer p2 )
+{
+    const guint32 *a = p1;
+    const guint32 *b = p2;
+    return ( *a > *b ) - ( *a < *b );
+}
+
+/**
+ * Collect the distinct trigrams of a row in the buffer of the worker.
+ * Trigrams do not cross the boundary between fields.
+ *
+ * @returns the trigrams, or NULL if the row has no strings to index.
+ */
+static GArray * trigram_row_keys ( const TrigramBuild *b, unsigned int worker, unsigned int row )
+{
+    GArray     *keys = b->scratch[worker];
+    const char *str;
+    if ( b->func ( row, 0, b->user_data ) == NULL ) {
+        return NULL;
+    }
+    g_array_set_size ( keys, 0 );
+    for ( unsigned int field = 0; ( str = b->func ( row, field, b->user_data ) ) != NULL; field++ ) {
+        guint32 key = 0;
+        for ( unsigned int i = 0; str[i] != '\0'; i++ ) {
+            key = ( key % ( TRIGRAM_SYMBOLS * TRIGRAM_SYMBOLS ) ) * TRIGRAM_SYMBOLS + trigram_symbol ( str[i] );
+            if ( i >= 2 ) {
+                g_array_append_val ( keys, key );
+            }
+        }
+    }
+    if ( keys->len > 1 ) {
+        guint32      *k = (guint32 *) keys->data;
+        unsigned int n  = 1;
+        g_array_sort ( keys, trigram_uint_compare );
+        for ( unsigned int i = 1; i < keys->len; i++ ) {
+            if ( k[i] != k[n - 1] ) {
+                k[n++] = k[i];
+            }
+        }
+        g_array_set_size ( keys, n );
+    }
+    return keys;
+}
+
+static void trigram_build_count ( unsigned int worker, G_GNUC_UNUSED unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data )
+{
+    TrigramBuild *b = (TrigramBuild *) user_data;
+    for ( unsigned int row = start; row < stop; row++ ) {
+        if ( ( ( row - start ) % TRIGRAM_CANCEL_CHECK ) == 0 && trigram_build_cancelled ( b ) ) {
+            return;
+        }
+        GArray *keys = trigram_row_keys ( b, worker, row );
+        if ( keys == NULL ) {
+            g_atomic_int_inc ( &( b->num_unindexed ) );
+            continue;
+        }
+        for ( unsigned int i = 0; i < keys->len; i++ ) {
+            g_atomic_int_inc ( &( b->counts[g_array_index ( keys, guint32, i )] ) );
+        }
+    }
+}
+
+static void trigram_build_fill ( unsigned int worker, G_GNUC_UNUSED unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data )
+{
+    TrigramBuild *b = (TrigramBuild *) user_data;
+    for ( unsigned int row = start; row < stop; row++ ) {
+        if ( ( ( row - start ) % TRIGRAM_CANCEL_CHECK ) == 0 && trigram_build_cancelled ( b ) ) {
+            return;
+        }
+        GArray *keys = trigram_row_keys ( b, worker, row );
+        if ( keys == NULL ) {
+            gint pos = g_atomic_int_add ( &( b->num_unindexed ), 1 );
+            b->index->unindexed[pos] = row;
+            continue;
+        }
+        for ( unsigned int i = 0; i < keys->len; i++ ) {
+            gint pos = g_atomic_int_add ( &( b->counts[g_array_index ( keys, guint32, i )] ), 1 );
+            b->index->rows[pos] = row;
+        }
+    }
+}
+
+static void trigram_build_sort ( G_GNUC_UNUSED unsigned int worker, G_GNUC_UNUSED unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data )
+{
+    TrigramBuild     *b     = (TrigramBuild *) user_data;
+    RofiTrigramIndex *index = b->index;
+    for ( unsigned int i = start; i < stop; i++ ) {
+        unsigned int *list = &( index->rows[index->start[i]] );
+        unsigned int n     = index->start[i + 1] - index->start[i];
+        // Each worker added its rows in order, check before sorting.
+        for ( unsigned int j = 1; j < n; j++ ) {
+            if ( list[j - 1] > list[j] ) {
+                qsort ( list, n, sizeof ( unsigned int ), trigram_uint_compare );
+                break;
+            }
+        }
+    }
+}
+
+void rofi_trigram_index_free ( RofiTrigramIndex *index )
+{
+    if ( index == NULL ) {
+        return;
+    }
+    g_free ( index->keys );
+    g_free ( index->start );
+    g_free ( index->rows );
+    g_free ( index->unindexed );
+    g_free ( index );
+}
+
+RofiTrigramIndex * rofi_trigram_index_new ( unsigned int num_rows, RofiTrigramTextFunc func, gpointer user_data, const gint *cancel )
+{
+    unsigned int      workers = rofi_parallel_num_workers ();
+    TrigramBuild      b       = {
+        .func      = func,
+        .user_data = user_data,
+        .cancel    = cancel,
+        .counts    = g_malloc0_n ( TRIGRAM_KEYS, sizeof ( gint ) ),
+        .scratch   = g_malloc_n ( workers, sizeof ( GArray * ) ),
+        .index     = g_malloc0 ( sizeof ( RofiTrigramIndex ) ),
+    };
+    RofiParallelRange range;
+    for ( unsigned int w = 0; w < workers; w++ ) {
+        b.scratch[w] = g_array_new ( FALSE, FALSE, sizeof ( guint32 ) );
+    }
+    // Count the rows of each trigram.
+    rofi_parallel_range_init ( &range, num_rows, TRIGRAM_MIN_CHUNK_SIZE );
+    rofi_parallel_for ( &range, trigram_build_count, &b );
+
+    // Lay out the posting lists, only for trigrams that occur.
+    RofiTrigramIndex *index = b.index;
+    guint64          total  = 0;
+    for ( unsigned int key = 0; key < TRIGRAM_KEYS; key++ ) {
+        if ( b.counts[key] > 0 ) {
+            index->num_keys++;
+            total += b.counts[key];
+        }
+    }
+    if ( trigram_build_cancelled ( &b ) ) {
+        g_free ( index );
+        index = NULL;
+    }
+    else if ( total < G_MAXINT ) {
+        index->keys  = g_malloc_n ( index->num_keys, sizeof ( guint32 ) );
+        index->start = g_malloc_n ( index->num_keys + 1, sizeof ( unsigned int ) );
+        index->rows  = g_malloc_n ( total + 1, sizeof ( unsigned int ) );
+        // Rows the mode cannot lend its strings for, e.g. combi rows of a mode without match strings.
+        index->num_unindexed = b.num_unindexed;
+        index->unindexed     = g_malloc_n ( index->num_unindexed + 1, sizeof ( unsigned int ) );
+        b.num_unindexed      = 0;
+        unsigned int i      = 0;
+        gint         offset = 0;
+        for ( unsigned int key = 0; key < TRIGRAM_KEYS; key++ ) {
+            if ( b.counts[key] > 0 ) {
+                gint count = b.counts[key];
+                index->keys[i]  = key;
+                index->start[i] = offset;
+                b.counts[key]   = offset;
+                offset         += count;
+                i++;
+            }
+        }
+        index->start[i] = offset;
+
+        // Fill the posting lists. Workers add their rows at the same time, so sort the lists after.
+        rofi_parallel_for ( &range, trigram_build_fill, &b );
+        rofi_parallel_range_init ( &range, index->num_keys, TRIGRAM_MIN_CHUNK_SIZE );
+        rofi_parallel_for ( &range, trigram_build_sort, &b );
+        qsort ( index->unindexed, index->num_unindexed, sizeof ( unsigned int ), trigram_uint_compare );
+        if ( trigram_build_cancelled ( &b ) ) {
+            rofi_trigram_index_free ( index );
+            index = NULL;
+        }
+        else {
+            g_debug ( "Indexed %u rows: %u trigrams, %d entries, %u rows without strings.", num_rows, index->num_keys, offset, index->num_unindexed );
+        }
+    }
+    else {
+        g_warning ( "Too many trigrams to index." );
+        g_free ( index );
+        index = NULL;
+    }
+
+    for ( unsigned int w = 0; w < workers; w++ ) {
+        g_array_free ( b.scratch[w], TRUE );
+    }
+    g_free ( b.scratch );
+    g_free ( b.counts );
+    return index;
+}
+
+/**
+ * Ignoring case, 'k' and 's' also match KELVIN SIGN and LATIN SMALL LETTER LONG S, and non-ASCII
+ * characters can match a case variant of a different length. Trigrams with these say nothing.
+ */
+static inline gboolean trigram_caseless_unsafe ( unsigned char c )
+{
+    return c >= 0x80 || c == 'k' || c == 'K' || c == 's' || c == 'S';
+}
+
+/**
+ * Add the trigrams of a literal part of the input to lists.
+ *
+ * @returns FALSE if some trigram does not occur at all, so no row can match.
+ */
+static gboolean trigram_add_literal ( const RofiTrigramIndex *index, const char *str, size_t len, gboolean case_sensitive, GArray *lists )
+{
+    for ( size_t i = 2; i < len; i++ ) {
+        const unsigned char *t = (const unsigned char *) &( str[i - 2] );
+        if ( !case_sensitive && ( trigram_caseless_unsafe ( t[0] ) || trigram_caseless_unsafe ( t[1] ) || trigram_caseless_unsafe ( t[2] ) ) ) {
+            continue;
+        }
+        guint32      key = ( trigram_symbol ( t[0] ) * TRIGRAM_SYMBOLS + trigram_symbol ( t[1] ) ) * TRIGRAM_SYMBOLS + trigram_symbol ( t[2] );
+        unsigned int lo  = 0, hi = index->num_keys;
+        while ( lo < hi ) {
+            unsigned int mid = lo + ( hi - lo ) / 2;
+            if ( index->keys[mid] < key ) {
+                lo = mid + 1;
+            }
+            else {
+                hi = mid;
+            }
+        }
+        if ( lo == index->num_keys || index->keys[lo] != key ) {
+            return FALSE;
+        }
+        g_array_append_val ( lists, lo );
+    }
+    return TRUE;
+}
+
+static gint trigram_list_compare ( gconstpointer p1, gconstpointer p2, gpointer data )
+{
+    const RofiTrigramIndex *index = data;
+    unsigned int           a      = *( (const unsigned int *) p1 );
+    unsigned int           b      = *( (const unsigned int *) p2 );
+    unsigned int           la     = index->start[a + 1] - index->start[a];
+    unsigned int           lb     = index->start[b + 1] - index->start[b];
+    if ( la != lb ) {
+        return ( la > lb ) - ( la < lb );
+    }
+    return ( a > b ) - ( a < b );
+}
+
+/**
+ * Find the first position at or after lo in list that is not smaller than value.
+ * Jump ahead in growing steps first, the next value is often close by.
+ */
+static unsigned int trigram_lower_bound ( const unsigned int *list, unsigned int lo, unsigned int n, unsigned int value )
+{
+    unsigned int hi   = lo;
+    unsigned int step = 1;
+    while ( hi < n && list[hi] < value ) {
+        lo    = hi + 1;
+        hi   += step;
+        step *= 2;
+    }
+    hi = MIN ( hi, n );
+    while ( lo < hi ) {
+        unsigned int mid = lo + ( hi - lo ) / 2;
+        if ( list[mid] < value ) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+gboolean rofi_trigram_index_query ( const RofiTrigramIndex *index, const char *pattern, int method, gboolean tokenize, gboolean case_sensitive, unsigned int **candidates, unsigned int *num_candidates )
+{
+    if ( index == NULL || pattern == NULL || ( method != MM_NORMAL && method != MM_GLOB ) ) {
+        return FALSE;
+    }
+    // Split the input like tokenize() does, and glob patterns on their wildcards.
+    gchar    **tokens = tokenize ? g_strsplit ( pattern, " ", 0 ) : g_strdupv ( (gchar *[]) { (gchar *) pattern, NULL } );
+    GArray   *lists   = g_array_new ( FALSE, FALSE, sizeof ( unsigned int ) );
+    gboolean possible = TRUE;
+    for ( unsigned int i = 0; possible && tokens[i] != NULL; i++ ) {
+        const char *token = tokens[i];
+        while ( possible && *token != '\0' ) {
+            size_t len = ( method == MM_GLOB ) ? strcspn ( token, "*?" ) : strlen ( token );
+            possible = trigram_add_literal ( index, token, len, case_sensitive, lists );
+            token   += len;
+            if ( *token != '\0' ) {
+                token++;
+            }
+        }
+    }
+    g_strfreev ( tokens );
+    if ( possible && lists->len == 0 ) {
+        g_array_free ( lists, TRUE );
+        return FALSE;
+    }
+
+    unsigned int *retv = NULL;
+    unsigned int n     = 0;
+    if ( possible ) {
+        // Start with the shortest list, each next list can only remove rows.
+        g_array_sort_with_data ( lists, trigram_list_compare, (gpointer) index );
+        unsigned int *l     = (unsigned int *) lists->data;
+        unsigned int first  = l[0];
+        n    = index->start[first + 1] - index->start[first];
+        retv = g_memdup ( &( index->rows[index->start[first]] ), n * sizeof ( unsigned int ) );
+        for ( unsigned int i = 1; i < lists->len && n > 0; i++ ) {
+            if ( l[i] == l[i - 1] ) {
+                continue;
+            }
+            const unsigned int *list = &( index->rows[index->start[l[i]]] );
+            unsigned int       len   = index->start[l[i] + 1] - index->start[l[i]];
+            unsigned int       pos   = 0, j = 0;
+            for ( unsigned int k = 0; k < n && pos < len; k++ ) {
+                pos = trigram_lower_bound ( list, pos, len, retv[k] );
+                if ( pos < len && list[pos] == retv[k] ) {
+                    retv[j++] = retv[k];
+                }
+            }
+            n = j;
+        }
+    }
+    g_array_free ( lists, TRUE );
+    // Rows that are not indexed can always match.
+    if ( index->num_unindexed > 0 ) {
+        const unsigned int *u      = index->unindexed;
+        unsigned int       nu      = index->num_unindexed;
+        unsigned int       *merged = g_malloc_n ( n + nu + 1, sizeof ( unsigned int ) );
+        unsigned int       i       = 0, j = 0, k = 0;
+        while ( i < n || j < nu ) {
+            if ( j == nu || ( i < n && retv[i] < u[j] ) ) {
+                merged[k++] = retv[i++];
+            }
+            else {
+                merged[k++] = u[j++];
+            }
+        }
+        g_free ( retv );
+        retv = merged;
+        n    = k;
+    }
+    *candidates     = retv;
+    *num_candidates = n;
+    return TRUE;
+}
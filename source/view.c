@@ -58,6 +58,10 @@
 #include "xkb-internal.h"
 #include "helper.h"
 #include "helper-theme.h"
+#include "parallel.h"
+#include "sort.h"
+#include "trigram.h"
+#include "fold.h"
 #include "x11-helper.h"
 #include "xrmoptions.h"
 #include "dialogs/dialogs.h"
@@ -78,7 +82,17 @@ void rofi_view_update ( RofiViewState *state, gboolean qr );
 
 static int rofi_view_calculate_height ( RofiViewState *state );
 
-/** Thread pool used for filtering */
+/** A run of the filter, see rofi_view_refilter() */
+typedef struct _filter_job   filter_job;
+
+static void rofi_view_refilter ( RofiViewState *state );
+static void rofi_view_filter_cancel_pending ( void );
+static void rofi_view_speculate_start ( RofiViewState *state, const filter_job *job );
+static void rofi_view_speculate_next ( void );
+static void rofi_view_result_cache_clear ( RofiViewState *state );
+static gboolean rofi_view_append_rows ( RofiViewState *state );
+
+/** Thread running filter jobs in the background. */
 GThreadPool *tpool = NULL;
 
 /** Global pointer to the currently active RofiViewState */
@@ -111,24 +125,50 @@ struct
     workarea           mon;
     /** timeout for reloading */
     guint              idle_timeout;
+    /** The pending reload can change rows the view already has, not only add rows. */
+    gboolean           reload_rows;
     /** debug counter for redraws */
     unsigned long long count;
     /** redraw idle time. */
     guint              repaint_source;
     /** Window fullscreen */
     gboolean           fullscreen;
+    /** Filter job running in the background, NULL if none. */
+    filter_job         *filter;
+    /** Generation of the last started filter job. */
+    guint              filter_generation;
+    /** timeout for a delayed re-filter */
+    guint              refilter_timeout;
+    /** How long the last re-filter took, in microseconds. */
+    gint64             refilter_cost;
+    /** Speculative filter job running in the background, NULL if none. */
+    filter_job         *speculate;
+    /** View the speculative filter jobs are for. */
+    RofiViewState      *speculate_view;
+    /** The input the speculative filter jobs extend. */
+    gchar              *speculate_text;
+    /** The characters still to filter on speculatively. */
+    gchar              *speculate_chars;
 } CacheState = {
-    .main_window    = XCB_WINDOW_NONE,
-    .fake_bg        = NULL,
-    .edit_surf      = NULL,
-    .edit_draw      = NULL,
-    .fake_bgrel     = FALSE,
-    .flags          = MENU_NORMAL,
-    .views          = G_QUEUE_INIT,
-    .idle_timeout   =               0,
-    .count          =              0L,
-    .repaint_source =               0,
-    .fullscreen     = FALSE,
+    .main_window      = XCB_WINDOW_NONE,
+    .fake_bg          = NULL,
+    .edit_surf        = NULL,
+    .edit_draw        = NULL,
+    .fake_bgrel       = FALSE,
+    .flags            = MENU_NORMAL,
+    .views            = G_QUEUE_INIT,
+    .idle_timeout     =               0,
+    .reload_rows      = FALSE,
+    .count            =              0L,
+    .repaint_source   =               0,
+    .fullscreen       = FALSE,
+    .filter           = NULL,
+    .refilter_timeout =               0,
+    .refilter_cost    =               0,
+    .speculate        = NULL,
+    .speculate_view   = NULL,
+    .speculate_text   = NULL,
+    .speculate_chars  = NULL,
 };
 
 void rofi_view_get_current_monitor ( int *width, int *height )
@@ -158,18 +198,6 @@ static char * get_matching_state ( void )
     return " ";
 }
 
-/**
- * Levenshtein Sorting.
- */
-static int lev_sort ( const void *p1, const void *p2, void *arg )
-{
-    const int *a         = p1;
-    const int *b         = p2;
-    int       *distances = arg;
-
-    return distances[*a] - distances[*b];
-}
-
 /**
  * Stores a screenshot of Rofi at that point in time.
  */
@@ -394,15 +422,26 @@ static void rofi_view_reload_message_bar ( RofiViewState *state )
 static gboolean rofi_view_reload_idle ( G_GNUC_UNUSED gpointer data )
 {
     if ( current_active_menu ) {
-        current_active_menu->reload   = TRUE;
-        current_active_menu->refilter = TRUE;
+        // When rows were only added, filter just those.
+        if ( CacheState.reload_rows || !rofi_view_append_rows ( current_active_menu ) ) {
+            current_active_menu->reload   = TRUE;
+            current_active_menu->refilter = TRUE;
+            rofi_view_refilter ( current_active_menu );
+        }
         rofi_view_queue_redraw ();
     }
     CacheState.idle_timeout = 0;
+    CacheState.reload_rows  = FALSE;
     return G_SOURCE_REMOVE;
 }
 
 void rofi_view_reload ( void  )
+{
+    CacheState.reload_rows = TRUE;
+    rofi_view_reload_append ();
+}
+
+void rofi_view_reload_append ( void )
 {
     // @TODO add check if current view is equal to the callee
     if ( CacheState.idle_timeout == 0 ) {
@@ -452,9 +491,35 @@ void rofi_view_set_active ( RofiViewState *state )
     rofi_view_queue_redraw ();
 }
 
+/** Number of rows put in order at a time when sorting, the rest is sorted when scrolled to. */
+#define FILTER_SORT_PAGE         256
+
+/**
+ * @param state The Menu Handle
+ * @param index The position in the filtered list, smaller than filtered_lines.
+ *
+ * The result is only sorted up to sorted_lines, sort the next page when we get past that.
+ *
+ * @returns the (unfiltered) line shown at position index.
+ */
+static unsigned int rofi_view_filtered_line ( RofiViewState *state, unsigned int index )
+{
+    if ( index >= state->sorted_lines ) {
+        unsigned int left = state->filtered_lines - state->sorted_lines;
+        unsigned int k    = MIN ( index - state->sorted_lines + FILTER_SORT_PAGE, left );
+        rofi_sort_partial ( &( state->line_map[state->sorted_lines] ), left, k, state->distance );
+        state->sorted_lines += k;
+    }
+    return state->line_map[index];
+}
+
 void rofi_view_set_selected_line ( RofiViewState *state, unsigned int selected_line )
 {
     state->selected_line = selected_line;
+    // The line can be anywhere, sort all.
+    if ( state->filtered_lines > 0 ) {
+        rofi_view_filtered_line ( state, state->filtered_lines - 1 );
+    }
     // Find the line.
     unsigned int selected = 0;
     for ( unsigned int i = 0; ( ( state->selected_line ) ) < UINT32_MAX && !selected && i < state->filtered_lines; i++ ) {
@@ -470,10 +535,15 @@ void rofi_view_set_selected_line ( RofiViewState *state, unsigned int selected_l
 
 void rofi_view_free ( RofiViewState *state )
 {
+    if ( ( CacheState.filter != NULL && CacheState.filter->state == state ) || CacheState.speculate_view == state ) {
+        rofi_view_filter_cancel_pending ();
+    }
     if ( state->tokens ) {
         tokenize_free ( state->tokens );
         state->tokens = NULL;
     }
+    g_free ( state->last_filter );
+    state->last_filter = NULL;
     // Do this here?
     // Wait for final release?
     widget_free ( WIDGET ( state->main_window ) );
@@ -481,6 +551,12 @@ void rofi_view_free ( RofiViewState *state )
 
     g_free ( state->line_map );
     g_free ( state->distance );
+    rofi_trigram_index_free ( state->trigram );
+    rofi_fold_corpus_free ( state->folded );
+    rofi_view_result_cache_clear ( state );
+    if ( state->match_spans != NULL ) {
+        g_hash_table_destroy ( state->match_spans );
+    }
     // Free the switcher boxes.
     // When state is free'ed we should no longer need these.
     if ( config.sidebar_mode == TRUE ) {
@@ -500,12 +576,12 @@ unsigned int rofi_view_get_selected_line ( const RofiViewState *state )
     return state->selected_line;
 }
 
-unsigned int rofi_view_get_next_position ( const RofiViewState *state )
+unsigned int rofi_view_get_next_position ( RofiViewState *state )
 {
     unsigned int next_pos = state->selected_line;
     unsigned int selected = listview_get_selected ( state->list_view );
     if ( ( selected + 1 ) < state->num_lines ) {
-        ( next_pos ) = state->line_map[selected + 1];
+        ( next_pos ) = rofi_view_filtered_line ( state, selected + 1 );
     }
     return next_pos;
 }
@@ -532,61 +608,355 @@ static RofiViewState * __rofi_view_state_create ( void )
 {
     return g_malloc0 ( sizeof ( RofiViewState ) );
 }
+/** Fewest rows worth handing to another thread when filtering. */
+#define FILTER_MIN_CHUNK_SIZE       500
+/** Number of rows to check before looking if the filter job got cancelled, also the rows matched per mode call. (multiple of 32) */
+#define FILTER_CANCEL_CHECK         256
+/** Lists with fewer rows to check are filtered in the main thread, it is not worth the round trip. */
+#define FILTER_ASYNC_MIN_ROWS       20000
+/** Lists with at least this many rows get a trigram index, built by the background filter job. */
+#define FILTER_INDEX_MIN_ROWS       10000
+/** Number of rows sampled to estimate how many rows each token matches. */
+#define FILTER_TOKEN_SAMPLE         128
+/** Number of recent filter results kept per view. */
+#define FILTER_RESULT_CACHE_SIZE    8
+/** Most matching rows kept over all cached filter results of a view. */
+#define FILTER_RESULT_CACHE_ROWS    ( 1 << 20 )
+/** Number of likely next characters filtered on while idle. */
+#define FILTER_SPECULATE_CHARS      3
+/** Shortest delay, in ms, before a lazy re-filter. */
+#define LAZY_FILTER_MIN_DELAY       20
+/** Longest delay, in ms, before a lazy re-filter, so results do not lag behind too much. */
+#define LAZY_FILTER_MAX_DELAY       150
+
 /**
- * Structure with data to process by each worker thread.
- */
-typedef struct _thread_state
-{
-    RofiViewState *state;
-    unsigned int  start;
-    unsigned int  stop;
-    unsigned int  count;
-    GCond         *cond;
-    GMutex        *mutex;
-    unsigned int  *acount;
-
-    const char    *pattern;
-    glong         plen;
-    void ( *callback )( struct _thread_state *t, gpointer data );
-}thread_state;
-/**
- * @param data A thread_state object.
- * @param user_data User data to pass to thread_state callback
- *
- * Small wrapper function that is internally used to pass a job to a worker.
+ * One run of the filter over the rows of a view.
+ * It is filled in by the main thread, run by the workers and applied to the view by the main thread.
+ * While it runs in the background it only reads the mode and the index and folded strings of the view,
+ * the view keeps sorting line_map in place meanwhile so the job checks a copy of it.
  */
-static void rofi_view_call_thread ( gpointer data, gpointer user_data )
+struct _filter_job
 {
-    thread_state *t = (thread_state *) data;
-    t->callback ( t, user_data );
-    g_mutex_lock ( t->mutex );
-    ( *( t->acount ) )--;
-    g_cond_signal ( t->cond );
-    g_mutex_unlock ( t->mutex );
-}
+    RofiViewState      *state;
+    Mode               *sw;
+    /** Generation of this job, the result is dropped if a newer job was started. */
+    guint              generation;
+    /** When the job was created, to measure the cost of filtering. */
+    gint64             start_time;
+    /** Set to stop the workers as soon as possible. */
+    gint               cancel;
+
+    rofi_int_matcher   **tokens;
+    /** The input as typed. */
+    gchar              *text;
+    gchar              *pattern;
+    glong              plen;
+    /** The input was not rewritten by the mode. */
+    gboolean           plain;
+    /** Settings at the moment the job was created. */
+    int                method;
+    unsigned int       case_sensitive;
+    unsigned int       sort;
+    unsigned int       tokenize;
+    unsigned int       levenshtein_sort;
+    /** The result was taken from the result cache, there is nothing to run. */
+    gboolean           cached;
+    /** Pattern prepared for levenshtein sorting, NULL if not sorting on levenshtein. */
+    LevenshteinNeedle  *lev_needle;
+    /** Number of rows of the view. */
+    unsigned int       num_lines;
+
+    /** Build the trigram index of the view before filtering. */
+    gboolean           build_index;
+    /** The index built by this job, handed to the view with the result. */
+    RofiTrigramIndex   *trigram;
+    /** Rows to check when owned by the job: the rows the index says can match, or a copy of the view's rows. */
+    unsigned int       *index_candidates;
+    /** Fold the strings of the rows before filtering. */
+    gboolean           build_fold;
+    /** The folded strings built by this job, handed to the view with the result. */
+    RofiFoldCorpus     *fold_built;
+    /** Folded strings to sort caseless on, NULL to fold each row while sorting. */
+    RofiFoldCorpus     *folded;
+
+    /** Rows to check, NULL to check all rows. */
+    const unsigned int *candidates;
+    /** First row to check when candidates is NULL, the rows from here on are checked. */
+    unsigned int       first_row;
+    unsigned int       num_candidates;
+    RofiParallelRange  range;
+    /** Number of matches found in each chunk. */
+    unsigned int       *chunk_count;
+    /** Number of matches at the start of each chunk that are sorted, when sorting. */
+    unsigned int       *chunk_sorted;
+    /** Where the matches of each chunk start, while putting them together. */
+    unsigned int       *chunk_offset;
+    /** The chunks put together, while doing so. */
+    unsigned int       *result;
+    /** The matching rows, in display order. */
+    unsigned int       *line_map;
+    unsigned int       filtered_lines;
+    /** Number of rows at the start of line_map that are sorted. */
+    unsigned int       sorted_lines;
+    /** Sort distance of each row, NULL if not sorting. Handed to the view with the result. */
+    int                *distance;
+
+    /** Protects done, signaled when the job finished. */
+    GMutex             lock;
+    GCond              cond;
+    gboolean           done;
+};
 
-static void filter_elements ( thread_state *t, G_GNUC_UNUSED gpointer user_data )
+/**
+ * Filter one chunk of rows. The matches are stored at the start of the chunk in line_map,
+ * rofi_view_filter_job_run() moves them together afterwards.
+ */
+static void filter_elements ( G_GNUC_UNUSED unsigned int worker, unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data )
 {
-    for ( unsigned int i = t->start; i < t->stop; i++ ) {
-        int match = mode_token_match ( t->state->sw, t->state->tokens, i );
+    filter_job   *t     = (filter_job *) user_data;
+    unsigned int count = 0;
+    guint32      matches[FILTER_CANCEL_CHECK / 32];
+    for ( unsigned int k = start; k < stop; k++ ) {
+        if ( ( ( k - start ) % FILTER_CANCEL_CHECK ) == 0 ) {
+            if ( g_atomic_int_get ( &( t->cancel ) ) ) {
+                break;
+            }
+            if ( t->candidates == NULL ) {
+                // Consecutive rows, the mode can match the whole block in one go.
+                memset ( matches, 0, sizeof ( matches ) );
+                mode_token_match_range ( t->sw, t->tokens, t->first_row + k, t->first_row + MIN ( stop, k + FILTER_CANCEL_CHECK ), matches );
+            }
+        }
+        unsigned int i     = ( t->candidates != NULL ) ? t->candidates[k] : t->first_row + k;
+        int          match = ( t->candidates != NULL ) ? mode_token_match ( t->sw, t->tokens, i )
+                             : helper_match_bitmap_get ( matches, ( k - start ) % FILTER_CANCEL_CHECK );
         // If each token was matched, add it to list.
         if ( match ) {
-            t->state->line_map[t->start + t->count] = i;
-            if ( config.sort ) {
-                // This is inefficient, need to fix it.
-                char  * str = mode_get_completion ( t->state->sw, i );
-                glong slen  = g_utf8_strlen ( str, -1 );
-                if ( config.levenshtein_sort || config.matching_method != MM_FUZZY  ) {
-                    t->state->distance[i] = levenshtein ( t->pattern, t->plen, str, slen );
+            t->line_map[start + count] = i;
+            if ( t->sort ) {
+                glong      slen = 0;
+                char       *tmp = NULL;
+                const char *str = mode_get_match_string ( t->sw, i, 0, &slen );
+                if ( str == NULL ) {
+                    // Mode cannot lend us the string, fall back to a copy.
+                    str  = tmp = mode_get_completion ( t->sw, i );
+                    slen = g_utf8_strlen ( str, -1 );
+                }
+                const char *folded = ( t->folded != NULL && tmp == NULL ) ? rofi_fold_corpus_get ( t->folded, i ) : NULL;
+                if ( t->lev_needle != NULL ) {
+                    t->distance[i] = folded ? levenshtein_needle_distance_folded ( t->lev_needle, folded, slen )
+                                     : levenshtein_needle_distance ( t->lev_needle, str, slen );
                 }
                 else {
-                    t->state->distance[i] = rofi_scorer_fuzzy_evaluate ( t->pattern, t->plen, str, slen );
+                    t->distance[i] = folded ? rofi_scorer_fuzzy_evaluate_folded ( t->pattern, t->plen, str, folded, slen, t->case_sensitive )
+                                     : rofi_scorer_fuzzy_evaluate ( t->pattern, t->plen, str, slen, t->case_sensitive );
                 }
-                g_free ( str );
+                g_free ( tmp );
+            }
+            count++;
+        }
+    }
+    t->chunk_count[chunk] = count;
+    // With more chunks, each sorts its first page here and those are merged afterwards.
+    if ( t->sort && t->range.num_chunks > 1 && !g_atomic_int_get ( &( t->cancel ) ) ) {
+        t->chunk_sorted[chunk] = MIN ( count, FILTER_SORT_PAGE );
+        rofi_sort_partial_serial ( &( t->line_map[start] ), count, t->chunk_sorted[chunk], t->distance );
+    }
+}
+
+/**
+ * Copy the matches of one chunk to their place in the result.
+ * When sorting, the sorted first page of the chunk is already merged, only the rest is copied.
+ */
+static void filter_gather ( G_GNUC_UNUSED unsigned int worker, unsigned int chunk, unsigned int start, G_GNUC_UNUSED unsigned int stop, gpointer user_data )
+{
+    filter_job   *t    = (filter_job *) user_data;
+    unsigned int skip = t->sort ? t->chunk_sorted[chunk] : 0;
+    memcpy ( &( t->result[t->chunk_offset[chunk]] ), &( t->line_map[start + skip] ), ( t->chunk_count[chunk] - skip ) * sizeof ( unsigned int ) );
+}
+
+/**
+ * Strings of a row for the trigram index, the ones the mode matches against.
+ */
+static const char * filter_index_text ( unsigned int row, unsigned int field, gpointer user_data )
+{
+    filter_job *t  = (filter_job *) user_data;
+    glong      len = 0;
+    return mode_get_match_string ( t->sw, row, field, &len );
+}
+
+/**
+ * Primary string of a row, for sorting caseless on the folded copy.
+ */
+static const char * filter_fold_text ( unsigned int row, gpointer user_data )
+{
+    filter_job *t  = (filter_job *) user_data;
+    glong      len = 0;
+    return mode_get_match_string ( t->sw, row, 0, &len );
+}
+
+/**
+ * @param job The job.
+ * @param index The trigram index of the rows.
+ *
+ * Only check the rows the index gives, if that is fewer than the job would check now.
+ */
+static void rofi_view_filter_job_use_index ( filter_job *job, const RofiTrigramIndex *index )
+{
+    unsigned int *candidates = NULL;
+    unsigned int n           = 0;
+    if ( !rofi_trigram_index_query ( index, job->pattern, job->method, job->tokenize, job->case_sensitive, &candidates, &n ) ) {
+        return;
+    }
+    if ( n < job->num_candidates ) {
+        g_debug ( "Trigram index: %u of %u rows.", n, job->num_lines );
+        g_free ( job->index_candidates );
+        job->index_candidates = candidates;
+        job->candidates       = candidates;
+        job->num_candidates   = n;
+    }
+    else {
+        g_free ( candidates );
+    }
+}
+
+/**
+ * @param job The job.
+ *
+ * Put the tokens that match the fewest rows first. Modes check the tokens in order and stop at the first
+ * one that does not match, so most rows are then rejected by the first token.
+ * How many rows a token matches is estimated on a sample of the rows to check. When narrowing these are the
+ * rows the previous input matched, so this is the selectivity within that result.
+ */
+static void rofi_view_filter_job_order_tokens ( filter_job *job )
+{
+    unsigned int num_tokens = 0;
+    while ( job->tokens != NULL && job->tokens[num_tokens] != NULL ) {
+        num_tokens++;
+    }
+    // On short lists the sample costs as much as it can save.
+    if ( num_tokens < 2 || job->num_candidates < 4 * FILTER_TOKEN_SAMPLE ) {
+        return;
+    }
+    unsigned int hits[num_tokens];
+    unsigned int step = job->num_candidates / FILTER_TOKEN_SAMPLE;
+    for ( unsigned int j = 0; j < num_tokens; j++ ) {
+        rofi_int_matcher *single[2] = { job->tokens[j], NULL };
+        hits[j] = 0;
+        for ( unsigned int k = 0; k < FILTER_TOKEN_SAMPLE; k++ ) {
+            unsigned int i = ( job->candidates != NULL ) ? job->candidates[k * step] : job->first_row + k * step;
+            if ( mode_token_match ( job->sw, single, i ) ) {
+                hits[j]++;
             }
-            t->count++;
         }
     }
+    // Tokens with equal hits keep the order they were typed in.
+    for ( unsigned int j = 1; j < num_tokens; j++ ) {
+        rofi_int_matcher *token = job->tokens[j];
+        unsigned int     h      = hits[j];
+        unsigned int     m      = j;
+        for (; m > 0 && hits[m - 1] > h; m-- ) {
+            job->tokens[m] = job->tokens[m - 1];
+            hits[m]        = hits[m - 1];
+        }
+        job->tokens[m] = token;
+        hits[m]        = h;
+    }
+}
+
+/**
+ * @param job The job to run.
+ *
+ * Filter and sort the rows. This can run in any thread.
+ */
+static void rofi_view_filter_job_run ( filter_job *job )
+{
+    if ( job->build_index ) {
+        job->trigram = rofi_trigram_index_new ( job->num_lines, filter_index_text, job, &( job->cancel ) );
+        if ( job->trigram != NULL ) {
+            rofi_view_filter_job_use_index ( job, job->trigram );
+        }
+    }
+    if ( job->build_fold ) {
+        job->fold_built = rofi_fold_corpus_new ( job->num_lines, filter_fold_text, job, &( job->cancel ) );
+        job->folded     = job->fold_built;
+    }
+    rofi_view_filter_job_order_tokens ( job );
+    rofi_parallel_range_init ( &( job->range ), job->num_candidates, FILTER_MIN_CHUNK_SIZE );
+    job->chunk_count  = g_malloc0_n ( job->range.num_chunks, sizeof ( unsigned int ) );
+    job->chunk_sorted = g_malloc0_n ( job->range.num_chunks, sizeof ( unsigned int ) );
+    job->line_map     = g_malloc_n ( job->num_candidates, sizeof ( unsigned int ) );
+    /**
+     * On long lists it can be beneficial to parallelize.
+     * The rows are cut in chunks that are spread over the workers, idle workers steal
+     * chunks from busy ones. Short lists stay in one chunk.
+     */
+    rofi_parallel_for ( &( job->range ), filter_elements, job );
+    if ( g_atomic_int_get ( &( job->cancel ) ) ) {
+        return;
+    }
+    unsigned int num_chunks = job->range.num_chunks;
+    job->filtered_lines = 0;
+    for ( unsigned int i = 0; i < num_chunks; i++ ) {
+        job->filtered_lines += job->chunk_count[i];
+    }
+    job->sorted_lines = job->filtered_lines;
+    if ( num_chunks <= 1 ) {
+        // The matches are already at the start of line_map.
+        if ( job->sort ) {
+            // Only sort what is shown first, the view sorts the rest when it gets there.
+            job->sorted_lines = MIN ( job->filtered_lines, FILTER_SORT_PAGE );
+            rofi_sort_partial ( job->line_map, job->filtered_lines, job->sorted_lines, job->distance );
+        }
+        return;
+    }
+    /**
+     * Put the chunks together, the workers each take a part of the result.
+     * When sorting, the first page of the result is in the sorted first pages of the chunks: these are merged
+     * and the rest of the rows go behind them, for the view to sort when it gets there.
+     * Otherwise the chunks are copied in row order.
+     */
+    job->result       = g_malloc_n ( job->filtered_lines + 1, sizeof ( unsigned int ) );
+    job->chunk_offset = g_malloc_n ( num_chunks, sizeof ( unsigned int ) );
+    unsigned int offset = 0;
+    if ( job->sort ) {
+        for ( unsigned int i = 0; i < num_chunks; i++ ) {
+            job->chunk_offset[i] = i * job->range.chunk_size;
+            offset              += job->chunk_sorted[i];
+        }
+        rofi_sort_merge ( job->result, job->line_map, job->chunk_offset, job->chunk_sorted, num_chunks, job->distance );
+        job->sorted_lines = MIN ( job->filtered_lines, FILTER_SORT_PAGE );
+    }
+    for ( unsigned int i = 0; i < num_chunks; i++ ) {
+        job->chunk_offset[i] = offset;
+        offset              += job->chunk_count[i] - ( job->sort ? job->chunk_sorted[i] : 0 );
+    }
+    rofi_parallel_for ( &( job->range ), filter_gather, job );
+    g_free ( job->chunk_offset );
+    job->chunk_offset = NULL;
+    g_free ( job->line_map );
+    job->line_map = job->result;
+    job->result   = NULL;
+}
+
+static void rofi_view_filter_job_free ( filter_job *job )
+{
+    if ( job->tokens ) {
+        tokenize_free ( job->tokens );
+    }
+    levenshtein_needle_free ( job->lev_needle );
+    g_free ( job->text );
+    g_free ( job->pattern );
+    g_free ( job->chunk_count );
+    g_free ( job->chunk_sorted );
+    g_free ( job->line_map );
+    g_free ( job->distance );
+    g_free ( job->index_candidates );
+    rofi_trigram_index_free ( job->trigram );
+    rofi_fold_corpus_free ( job->fold_built );
+    g_mutex_clear ( &( job->lock ) );
+    g_cond_clear ( &( job->cond ) );
+    g_free ( job );
 }
 static void rofi_view_setup_fake_transparency ( const char* const fake_background )
 {
@@ -824,7 +1194,7 @@ static void rofi_view_nav_row_tab ( RofiViewState *state )
 {
     if ( state->filtered_lines == 1 ) {
         state->retv              = MENU_OK;
-        ( state->selected_line ) = state->line_map[listview_get_selected ( state->list_view )];
+        ( state->selected_line ) = rofi_view_filtered_line ( state, listview_get_selected ( state->list_view ) );
         state->quit              = 1;
         return;
     }
@@ -853,7 +1223,7 @@ inline static void rofi_view_nav_row_select ( RofiViewState *state )
     unsigned int selected = listview_get_selected ( state->list_view );
     // If a valid item is selected, return that..
     if ( selected < state->filtered_lines ) {
-        char *str = mode_get_completion ( state->sw, state->line_map[selected] );
+        char *str = mode_get_completion ( state->sw, rofi_view_filtered_line ( state, selected ) );
         textbox_text ( state->text, str );
         g_free ( str );
         textbox_keybinding ( state->text, MOVE_END );
@@ -887,13 +1257,77 @@ inline static void rofi_view_nav_last ( RofiViewState * state )
     listview_set_selected ( state->list_view, -1 );
 }
 
+/** Number of rows to keep the highlighted parts of. */
+#define VIEW_MATCH_SPAN_CACHE_SIZE    256
+
+/**
+ * Highlighted parts of the text shown for a row.
+ */
+typedef struct
+{
+    /** The text the spans are for. */
+    char   *text;
+    GArray *spans;
+} MatchSpans;
+
+static void match_spans_free ( gpointer data )
+{
+    MatchSpans *ms = (MatchSpans *) data;
+    g_free ( ms->text );
+    g_array_free ( ms->spans, TRUE );
+    g_free ( ms );
+}
+
+/**
+ * @param state The Menu Handle
+ *
+ * Drop the highlighted parts, the tokens changed.
+ */
+static void rofi_view_match_spans_clear ( RofiViewState *state )
+{
+    if ( state->match_spans != NULL ) {
+        g_hash_table_remove_all ( state->match_spans );
+    }
+}
+
+/**
+ * @param state The Menu Handle
+ * @param row The row.
+ * @param text The text shown for the row.
+ *
+ * Get the parts of the shown text that match the tokens. These only change with the tokens,
+ * so they are kept for redraws (e.g. moving the selection) instead of matching every row again.
+ * The filter itself matches against the strings of the mode, which are not the shown text, so its matches cannot be used.
+ *
+ * @returns the array of #rofi_match_span, owned by the view.
+ */
+static const GArray * rofi_view_get_match_spans ( RofiViewState *state, unsigned int row, const char *text )
+{
+    if ( state->match_spans == NULL ) {
+        state->match_spans = g_hash_table_new_full ( g_direct_hash, g_direct_equal, NULL, match_spans_free );
+    }
+    MatchSpans *ms = (MatchSpans *) g_hash_table_lookup ( state->match_spans, GUINT_TO_POINTER ( row ) );
+    if ( ms != NULL && g_strcmp0 ( ms->text, text ) == 0 ) {
+        return ms->spans;
+    }
+    if ( g_hash_table_size ( state->match_spans ) >= VIEW_MATCH_SPAN_CACHE_SIZE ) {
+        g_hash_table_remove_all ( state->match_spans );
+    }
+    ms        = g_malloc ( sizeof ( MatchSpans ) );
+    ms->text  = g_strdup ( text );
+    ms->spans = helper_token_match_get_spans ( state->tokens, text );
+    g_hash_table_replace ( state->match_spans, GUINT_TO_POINTER ( row ), ms );
+    return ms->spans;
+}
+
 static void update_callback ( textbox *t, unsigned int index, void *udata, TextBoxFontType type, gboolean full )
 {
     RofiViewState *state = (RofiViewState *) udata;
     if ( full ) {
-        GList *add_list = NULL;
-        int   fstate    = 0;
-        char  *text     = mode_get_display_value ( state->sw, state->line_map[index], &fstate, &add_list, TRUE );
+        GList        *add_list = NULL;
+        int          fstate    = 0;
+        unsigned int row       = rofi_view_filtered_line ( state, index );
+        char         *text     = mode_get_display_value ( state->sw, row, &fstate, &add_list, TRUE );
         type |= fstate;
         textbox_font ( t, type );
         // Move into list view.
@@ -909,7 +1343,7 @@ static void update_callback ( textbox *t, unsigned int index, void *udata, TextB
         if ( state->tokens && config.show_match ) {
             ThemeHighlight th = { HL_BOLD | HL_UNDERLINE, { 0.0, 0.0, 0.0, 0.0 } };
             th = rofi_theme_get_highlight ( WIDGET ( t ), "highlight", th );
-            helper_token_match_get_pango_attr ( th, state->tokens, textbox_get_visible_text ( t ), list );
+            helper_match_spans_get_pango_attr ( th, rofi_view_get_match_spans ( state, row, textbox_get_visible_text ( t ) ), list );
         }
         for ( GList *iter = g_list_first ( add_list ); iter != NULL; iter = g_list_next ( iter ) ) {
             pango_attr_list_insert ( list, (PangoAttribute *) ( iter->data ) );
@@ -921,7 +1355,7 @@ static void update_callback ( textbox *t, unsigned int index, void *udata, TextB
     }
     else {
         int fstate = 0;
-        mode_get_display_value ( state->sw, state->line_map[index], &fstate, NULL, FALSE );
+        mode_get_display_value ( state->sw, rofi_view_filtered_line ( state, index ), &fstate, NULL, FALSE );
         type |= fstate;
         textbox_font ( t, type );
     }
@@ -1028,111 +1462,841 @@ static void rofi_view_mouse_navigation ( RofiViewState *state, xcb_button_press_
         }
     }
 }
+/**
+ * @param state The Menu Handle
+ * @param num_lines The number of rows.
+ *
+ * Make room for num_lines rows in line_map and distance. They grow geometrically, so rows that
+ * come in a block at a time do not copy the arrays for every block.
+ */
+static void rofi_view_rows_reserve ( RofiViewState *state, unsigned int num_lines )
+{
+    if ( num_lines <= state->line_map_size ) {
+        return;
+    }
+    state->line_map_size = MAX ( num_lines, MIN ( state->line_map_size, G_MAXUINT / 2 ) * 2 );
+    state->line_map      = g_realloc_n ( state->line_map, state->line_map_size, sizeof ( unsigned int ) );
+    state->distance      = g_realloc_n ( state->distance, state->line_map_size, sizeof ( int ) );
+}
+
 static void _rofi_view_reload_row ( RofiViewState *state )
 {
-    g_free ( state->line_map );
-    g_free ( state->distance );
     state->num_lines = mode_get_num_entries ( state->sw );
-    state->line_map  = g_malloc0_n ( state->num_lines, sizeof ( unsigned int ) );
-    state->distance  = g_malloc0_n ( state->num_lines, sizeof ( int ) );
+    rofi_view_rows_reserve ( state, state->num_lines );
+    // Index and cached results are for the old rows.
+    rofi_view_result_cache_clear ( state );
+    rofi_view_match_spans_clear ( state );
+    rofi_trigram_index_free ( state->trigram );
+    rofi_fold_corpus_free ( state->folded );
+    state->trigram     = NULL;
+    state->folded      = NULL;
+    state->rows_stable = FALSE;
     listview_set_max_lines ( state->list_view, state->num_lines );
     rofi_view_reload_message_bar ( state );
 }
 
-static void rofi_view_refilter ( RofiViewState *state )
+/**
+ * @param state The Menu Handle
+ * @param input The new (preprocessed) input.
+ *
+ * Check if the new input can only match a subset of the current filtered list.
+ * This is the case when the input extends the previous input (typing more characters or adding a token) and the
+ * matching settings did not change. Regex is excluded, as adding characters to a regex can make it match more.
+ *
+ * @returns TRUE if only the rows in line_map need to be checked.
+ */
+static gboolean rofi_view_filter_can_narrow ( const RofiViewState *state, const char *input )
 {
-    TICK_N ( "Filter start" );
-    if ( state->reload ) {
-        _rofi_view_reload_row ( state );
-        state->reload = FALSE;
+    if ( state->last_filter == NULL || input == NULL ) {
+        return FALSE;
+    }
+    if ( config.matching_method == MM_REGEX || (int) config.matching_method != state->last_filter_method ) {
+        return FALSE;
+    }
+    if ( config.case_sensitive != state->last_filter_case || config.sort != state->last_filter_sort ) {
+        return FALSE;
+    }
+    return g_str_has_prefix ( input, state->last_filter );
+}
+
+/**
+ * @param state The Menu Handle
+ *
+ * Check if data derived from the rows (trigram index, folded strings) is worth building.
+ * It is built by the background filter job, and only once the rows settled: while rows are still coming in
+ * (e.g. dmenu reading its input) it would be outdated right away.
+ *
+ * @returns TRUE if the rows are long and settled.
+ */
+static gboolean rofi_view_filter_rows_settled ( const RofiViewState *state )
+{
+    glong len = 0;
+    if ( tpool == NULL || config.auto_select || !state->rows_stable || CacheState.idle_timeout > 0 ) {
+        return FALSE;
+    }
+    if ( state->num_lines < FILTER_INDEX_MIN_ROWS ) {
+        return FALSE;
+    }
+    // The mode has to lend us the strings it matches against. Rows it cannot lend them for (e.g. combi rows
+    // of a mode without match strings) are not indexed and checked on every input.
+    return mode_get_match_string ( state->sw, 0, 0, &len ) != NULL;
+}
+
+/**
+ * @param state The Menu Handle
+ *
+ * Check if a trigram index is worth building for the rows of the view.
+ * Regex and fuzzy matching cannot use it.
+ *
+ * @returns TRUE if the next filter job should build the index.
+ */
+static gboolean rofi_view_filter_can_index ( const RofiViewState *state )
+{
+    if ( config.matching_method != MM_NORMAL && config.matching_method != MM_GLOB ) {
+        return FALSE;
+    }
+    return rofi_view_filter_rows_settled ( state );
+}
+
+/**
+ * @param state The Menu Handle
+ *
+ * Update the view after the filtered list changed.
+ */
+static void rofi_view_refilter_done ( RofiViewState *state )
+{
+    listview_set_num_elements ( state->list_view, state->filtered_lines );
+
+    if ( config.auto_select == TRUE && state->filtered_lines == 1 && state->num_lines > 1 ) {
+        ( state->selected_line ) = rofi_view_filtered_line ( state, listview_get_selected ( state->list_view  ) );
+        state->retv              = MENU_OK;
+        state->quit              = TRUE;
+    }
+    // Size the window.
+    int height = rofi_view_calculate_height ( state );
+    if ( height != state->height ) {
+        state->height = height;
+        rofi_view_calculate_window_position ( state );
+        rofi_view_window_update_size ( state );
+        g_debug ( "Resize based on re-filter" );
+    }
+    TICK_N ( "Filter done" );
+}
+
+/**
+ * Result of filtering on an input, kept so going back to that input (backspace, history) is instant.
+ */
+typedef struct
+{
+    /** The input as typed. */
+    char         *text;
+    /** Settings the result was filtered with. */
+    int          method;
+    unsigned int case_sensitive;
+    unsigned int sort;
+    unsigned int levenshtein_sort;
+    unsigned int tokenize;
+    unsigned int *line_map;
+    /** Sort distance of each row in line_map, NULL if not sorting. */
+    int          *distance;
+    unsigned int filtered_lines;
+    unsigned int sorted_lines;
+} FilterResult;
+
+static void filter_result_free ( gpointer data )
+{
+    FilterResult *r = (FilterResult *) data;
+    g_free ( r->text );
+    g_free ( r->line_map );
+    g_free ( r->distance );
+    g_free ( r );
+}
+
+/**
+ * @param state The Menu Handle
+ *
+ * Drop the cached filter results, e.g. because the rows changed.
+ */
+static void rofi_view_result_cache_clear ( RofiViewState *state )
+{
+    g_list_free_full ( state->result_cache, filter_result_free );
+    state->result_cache = NULL;
+}
+
+/**
+ * @param state The Menu Handle
+ * @param text The input.
+ *
+ * Look for a cached result for the input with the current settings.
+ *
+ * @returns the list element holding the result, or NULL if there is none.
+ */
+static GList * rofi_view_result_cache_find ( const RofiViewState *state, const char *text )
+{
+    for ( GList *iter = state->result_cache; iter != NULL; iter = g_list_next ( iter ) ) {
+        const FilterResult *r = (const FilterResult *) iter->data;
+        if ( (int) config.matching_method == r->method && config.case_sensitive == r->case_sensitive &&
+             config.sort == r->sort && config.levenshtein_sort == r->levenshtein_sort && config.tokenize == r->tokenize &&
+             g_strcmp0 ( text, r->text ) == 0 ) {
+            return iter;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @param state The Menu Handle
+ * @param job The finished filter job.
+ *
+ * Keep the result of the job. The least recently used results are dropped to stay within
+ * #FILTER_RESULT_CACHE_SIZE results and #FILTER_RESULT_CACHE_ROWS rows.
+ */
+static void rofi_view_result_cache_add ( RofiViewState *state, const filter_job *job )
+{
+    if ( job->filtered_lines > FILTER_RESULT_CACHE_ROWS ) {
+        return;
+    }
+    FilterResult *r = g_malloc0 ( sizeof ( FilterResult ) );
+    r->text             = g_strdup ( job->text );
+    r->method           = job->method;
+    r->case_sensitive   = job->case_sensitive;
+    r->sort             = job->sort;
+    r->levenshtein_sort = job->levenshtein_sort;
+    r->tokenize         = job->tokenize;
+    r->filtered_lines   = job->filtered_lines;
+    r->sorted_lines     = job->sorted_lines;
+    r->line_map         = g_memdup ( job->line_map, job->filtered_lines * sizeof ( unsigned int ) );
+    if ( job->distance != NULL ) {
+        // Only the distances of the matching rows, in line_map order.
+        r->distance = g_malloc_n ( job->filtered_lines, sizeof ( int ) );
+        for ( unsigned int i = 0; i < job->filtered_lines; i++ ) {
+            r->distance[i] = job->distance[job->line_map[i]];
+        }
+    }
+    state->result_cache = g_list_prepend ( state->result_cache, r );
+
+    unsigned int count = 0, rows = 0;
+    GList        *iter = state->result_cache;
+    while ( iter != NULL ) {
+        GList *next = g_list_next ( iter );
+        count++;
+        rows += ( (FilterResult *) iter->data )->filtered_lines;
+        if ( count > FILTER_RESULT_CACHE_SIZE || rows > FILTER_RESULT_CACHE_ROWS ) {
+            filter_result_free ( iter->data );
+            state->result_cache = g_list_delete_link ( state->result_cache, iter );
+        }
+        iter = next;
+    }
+}
+
+/**
+ * @param state The Menu Handle
+ * @param job The new filter job.
+ *
+ * Fill in the result of the job from the cache, if the current input was filtered on recently.
+ *
+ * @returns TRUE if the job got its result from the cache.
+ */
+static gboolean rofi_view_result_cache_restore ( RofiViewState *state, filter_job *job )
+{
+    GList *link = rofi_view_result_cache_find ( state, job->text );
+    if ( link == NULL ) {
+        return FALSE;
+    }
+    // Most recently used goes to the front.
+    state->result_cache = g_list_remove_link ( state->result_cache, link );
+    state->result_cache = g_list_concat ( link, state->result_cache );
+
+    const FilterResult *r = (const FilterResult *) link->data;
+    job->cached         = TRUE;
+    job->filtered_lines = r->filtered_lines;
+    job->sorted_lines   = r->sorted_lines;
+    job->line_map       = g_memdup ( r->line_map, r->filtered_lines * sizeof ( unsigned int ) );
+    if ( r->distance != NULL ) {
+        job->distance = g_malloc_n ( state->line_map_size, sizeof ( int ) );
+        for ( unsigned int i = 0; i < r->filtered_lines; i++ ) {
+            job->distance[r->line_map[i]] = r->distance[i];
+        }
+    }
+    g_debug ( "Filter result taken from cache: %u rows.", r->filtered_lines );
+    return TRUE;
+}
+
+/**
+ * @param state The Menu Handle
+ * @param text The input to filter on.
+ *
+ * Setup a filter job that checks all rows of the view on the input, with the current settings.
+ *
+ * @returns a new filter job.
+ */
+static filter_job * rofi_view_filter_job_prepare ( RofiViewState *state, const char *text )
+{
+    filter_job *job = g_malloc0 ( sizeof ( filter_job ) );
+    g_mutex_init ( &( job->lock ) );
+    g_cond_init ( &( job->cond ) );
+    job->state            = state;
+    job->sw               = state->sw;
+    job->generation       = ++( CacheState.filter_generation );
+    job->start_time       = g_get_monotonic_time ();
+    job->pattern          = mode_preprocess_input ( state->sw, text );
+    job->plen             = job->pattern ? g_utf8_strlen ( job->pattern, -1 ) : 0;
+    job->tokens           = tokenize ( job->pattern, config.case_sensitive );
+    job->text             = g_strdup ( text );
+    job->plain            = g_strcmp0 ( job->pattern, text ) == 0;
+    job->method           = config.matching_method;
+    job->case_sensitive   = config.case_sensitive;
+    job->sort             = config.sort;
+    job->tokenize         = config.tokenize;
+    job->levenshtein_sort = config.levenshtein_sort;
+    job->num_lines        = state->num_lines;
+    job->num_candidates   = state->num_lines;
+    // Decode the pattern once for all rows, instead of for every row.
+    if ( job->sort && ( config.levenshtein_sort || job->method != MM_FUZZY ) ) {
+        job->lev_needle = levenshtein_needle_new ( job->pattern, job->plen, job->case_sensitive );
+    }
+    return job;
+}
+
+/**
+ * @param state The Menu Handle
+ * @param text The input to filter on, normally the current input of the view.
+ *
+ * Prepare a filter job for the input.
+ *
+ * @returns a new filter job.
+ */
+static filter_job * rofi_view_filter_job_new ( RofiViewState *state, const char *text )
+{
+    filter_job *job = rofi_view_filter_job_prepare ( state, text );
+    if ( rofi_view_result_cache_restore ( state, job ) ) {
+        return job;
+    }
+    /**
+     * If the input was only extended, the new result is a subset of the old one.
+     * Only check the rows that matched last time. When the mode rewrites the input
+     * (e.g. combi's !bang) we cannot tell, so do a full scan.
+     */
+    if ( job->plain && rofi_view_filter_can_narrow ( state, job->pattern ) ) {
+        job->candidates     = state->line_map;
+        job->num_candidates = state->filtered_lines;
+        g_debug ( "Narrowing previous result: %u of %u rows.", job->num_candidates, state->num_lines );
+    }
+    if ( state->trigram != NULL ) {
+        rofi_view_filter_job_use_index ( job, state->trigram );
+    }
+    else {
+        job->build_index = rofi_view_filter_can_index ( state );
+    }
+    // Sorting caseless folds every matching row, on long lists fold them all once.
+    if ( job->sort && !job->case_sensitive ) {
+        if ( state->folded != NULL ) {
+            job->folded = state->folded;
+        }
+        else {
+            job->build_fold = rofi_view_filter_rows_settled ( state );
+        }
+    }
+    // The view keeps sorting the shown result with its distances while this job runs.
+    // Room for as many rows as the view has, so rows can be appended to the result.
+    if ( job->sort ) {
+        job->distance = g_malloc_n ( state->line_map_size, sizeof ( int ) );
+    }
+    return job;
+}
+
+/**
+ * @param job The filter job.
+ *
+ * Let a job that narrows the shown result check a copy of line_map, before it goes to the background thread.
+ * The view sorts the unsorted part of line_map in place when it is scrolled to, meanwhile.
+ */
+static void rofi_view_filter_job_detach ( filter_job *job )
+{
+    if ( job->candidates != NULL && job->candidates == job->state->line_map ) {
+        job->index_candidates = g_memdup ( job->candidates, job->num_candidates * sizeof ( unsigned int ) );
+        job->candidates       = job->index_candidates;
+    }
+}
+
+/**
+ * @param state The Menu Handle
+ * @param job The finished filter job.
+ *
+ * Show the result of the job.
+ */
+static void rofi_view_filter_job_apply ( RofiViewState *state, filter_job *job )
+{
+    if ( !job->cached ) {
+        CacheState.refilter_cost = g_get_monotonic_time () - job->start_time;
+        rofi_view_result_cache_add ( state, job );
     }
     if ( state->tokens ) {
         tokenize_free ( state->tokens );
-        state->tokens = NULL;
     }
-    if ( strlen ( state->text->text ) > 0 ) {
-        unsigned int j        = 0;
-        gchar        *pattern = mode_preprocess_input ( state->sw, state->text->text );
-        glong        plen     = pattern ? g_utf8_strlen ( pattern, -1 ) : 0;
-        state->tokens = tokenize ( pattern, config.case_sensitive );
-        /**
-         * On long lists it can be beneficial to parallelize.
-         * If number of threads is 1, no thread is spawn.
-         * If number of threads > 1 and there are enough (> 1000) items, spawn jobs for the thread pool.
-         * For large lists with 8 threads I see a factor three speedup of the whole function.
-         */
-        unsigned int nt = MAX ( 1, state->num_lines / 500 );
-        thread_state states[nt];
-        GCond        cond;
-        GMutex       mutex;
-        g_mutex_init ( &mutex );
-        g_cond_init ( &cond );
-        unsigned int count = nt;
-        unsigned int steps = ( state->num_lines + nt ) / nt;
-        for ( unsigned int i = 0; i < nt; i++ ) {
-            states[i].state    = state;
-            states[i].start    = i * steps;
-            states[i].stop     = MIN ( state->num_lines, ( i + 1 ) * steps );
-            states[i].count    = 0;
-            states[i].cond     = &cond;
-            states[i].mutex    = &mutex;
-            states[i].acount   = &count;
-            states[i].plen     = plen;
-            states[i].pattern  = pattern;
-            states[i].callback = filter_elements;
-            if ( i > 0 ) {
-                g_thread_pool_push ( tpool, &states[i], NULL );
-            }
+    // The tokens are used for highlighting the matches.
+    state->tokens = job->tokens;
+    job->tokens   = NULL;
+    rofi_view_match_spans_clear ( state );
+    if ( job->filtered_lines > 0 ) {
+        memcpy ( state->line_map, job->line_map, job->filtered_lines * sizeof ( unsigned int ) );
+    }
+    state->filtered_lines = job->filtered_lines;
+    state->sorted_lines   = job->sorted_lines;
+    if ( job->trigram != NULL ) {
+        rofi_trigram_index_free ( state->trigram );
+        state->trigram = job->trigram;
+        job->trigram   = NULL;
+    }
+    if ( job->fold_built != NULL ) {
+        rofi_fold_corpus_free ( state->folded );
+        state->folded   = job->fold_built;
+        job->fold_built = NULL;
+    }
+    if ( job->distance != NULL ) {
+        g_free ( state->distance );
+        state->distance = job->distance;
+        job->distance   = NULL;
+    }
+
+    g_free ( state->last_filter );
+    state->last_filter = NULL;
+    if ( job->plain && job->method != MM_REGEX ) {
+        state->last_filter        = job->pattern;
+        state->last_filter_method = job->method;
+        state->last_filter_case   = job->case_sensitive;
+        state->last_filter_sort   = job->sort;
+        job->pattern              = NULL;
+    }
+    rofi_view_refilter_done ( state );
+    rofi_view_speculate_start ( state, job );
+}
+
+static void rofi_view_filter_job_wait ( filter_job *job )
+{
+    g_mutex_lock ( &( job->lock ) );
+    while ( !job->done ) {
+        g_cond_wait ( &( job->cond ), &( job->lock ) );
+    }
+    g_mutex_unlock ( &( job->lock ) );
+}
+
+/**
+ * Idle handler called when a background filter job finished.
+ * The data holds the generation of the job, notifications of jobs that were cancelled or
+ * already applied are dropped.
+ */
+static gboolean rofi_view_filter_job_done_idle ( gpointer data )
+{
+    filter_job *job = CacheState.speculate;
+    if ( job != NULL && job->generation == GPOINTER_TO_UINT ( data ) ) {
+        // Keep the speculative result for when the input gets there, and go on with the next character.
+        CacheState.speculate = NULL;
+        rofi_view_filter_job_wait ( job );
+        rofi_view_result_cache_add ( job->state, job );
+        rofi_view_filter_job_free ( job );
+        rofi_view_speculate_next ();
+        return G_SOURCE_REMOVE;
+    }
+    job = CacheState.filter;
+    if ( job == NULL || job->generation != GPOINTER_TO_UINT ( data ) ) {
+        return G_SOURCE_REMOVE;
+    }
+    CacheState.filter = NULL;
+    rofi_view_filter_job_wait ( job );
+    rofi_view_filter_job_apply ( job->state, job );
+    rofi_view_filter_job_free ( job );
+    rofi_view_queue_redraw ();
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * @param data The filter job.
+ * @param user_data Unused.
+ *
+ * Run a filter job in the background thread.
+ */
+static void rofi_view_filter_job_thread ( gpointer data, G_GNUC_UNUSED gpointer user_data )
+{
+    filter_job *job       = (filter_job *) data;
+    guint      generation = job->generation;
+    rofi_view_filter_job_run ( job );
+    g_mutex_lock ( &( job->lock ) );
+    job->done = TRUE;
+    g_cond_broadcast ( &( job->cond ) );
+    g_mutex_unlock ( &( job->lock ) );
+    // The main thread can free the job from here on, so only pass the generation.
+    g_idle_add_full ( G_PRIORITY_DEFAULT, rofi_view_filter_job_done_idle, GUINT_TO_POINTER ( generation ), NULL );
+}
+
+/**
+ * Stop the speculative filter job, if any, and drop the characters still to do.
+ */
+static void rofi_view_speculate_cancel ( void )
+{
+    filter_job *job = CacheState.speculate;
+    if ( job != NULL ) {
+        CacheState.speculate = NULL;
+        g_atomic_int_set ( &( job->cancel ), TRUE );
+        rofi_view_filter_job_wait ( job );
+        rofi_view_filter_job_free ( job );
+    }
+    g_free ( CacheState.speculate_text );
+    g_free ( CacheState.speculate_chars );
+    CacheState.speculate_text  = NULL;
+    CacheState.speculate_chars = NULL;
+    CacheState.speculate_view  = NULL;
+}
+
+/**
+ * Stop the background filter jobs, if any, and drop their results.
+ * Returns when no worker touches the mode anymore.
+ */
+static void rofi_view_filter_cancel_pending ( void )
+{
+    rofi_view_speculate_cancel ();
+    filter_job *job = CacheState.filter;
+    if ( job == NULL ) {
+        return;
+    }
+    CacheState.filter = NULL;
+    g_atomic_int_set ( &( job->cancel ), TRUE );
+    rofi_view_filter_job_wait ( job );
+    rofi_view_filter_job_free ( job );
+}
+
+void rofi_view_cancel_filter ( void )
+{
+    if ( CacheState.filter != NULL ) {
+        // Result is lost, filter again later.
+        CacheState.filter->state->refilter = TRUE;
+    }
+    rofi_view_filter_cancel_pending ();
+}
+
+/**
+ * @param state The Menu Handle
+ *
+ * Check if the running speculative filter job is for the current input and settings of the view.
+ *
+ * @returns TRUE if its result is the one the view needs.
+ */
+static gboolean rofi_view_speculate_matches ( const RofiViewState *state )
+{
+    const filter_job *job = CacheState.speculate;
+    if ( job == NULL || job->state != state || g_strcmp0 ( job->text, state->text->text ) != 0 ) {
+        return FALSE;
+    }
+    return job->method == (int) config.matching_method && job->case_sensitive == config.case_sensitive &&
+           job->sort == config.sort && job->levenshtein_sort == config.levenshtein_sort && job->tokenize == config.tokenize;
+}
+
+/**
+ * @param state The Menu Handle
+ * @param job The job that just got applied.
+ *
+ * Pick the characters most likely typed next, from a sample of the matching rows.
+ * With normal matching these are the characters following the last word of the input in the rows,
+ * otherwise the characters occurring in most rows.
+ *
+ * @returns the characters, most likely first, or NULL if there are none.
+ */
+static gchar * rofi_view_speculate_pick ( const RofiViewState *state, const filter_job *job )
+{
+    const char   *space      = job->tokenize ? strrchr ( job->text, ' ' ) : NULL;
+    const char   *word       = ( space != NULL ) ? space + 1 : job->text;
+    size_t       wlen        = strlen ( word );
+    unsigned int counts[128] = { 0 };
+    unsigned int step        = MAX ( job->filtered_lines / FILTER_TOKEN_SAMPLE, 1 );
+    if ( wlen == 0 ) {
+        // Next character starts a new token, anything goes.
+        return NULL;
+    }
+    for ( unsigned int k = 0; k < FILTER_TOKEN_SAMPLE && k * step < job->filtered_lines; k++ ) {
+        glong      len       = 0;
+        const char *str      = mode_get_match_string ( state->sw, job->line_map[k * step], 0, &len );
+        gboolean   seen[128] = { FALSE };
+        if ( str == NULL ) {
+            // Mode cannot lend us the strings, not worth copying them all.
+            return NULL;
         }
-        // Run one in this thread.
-        rofi_view_call_thread ( &states[0], NULL );
-        // No need to do this with only one thread.
-        if ( nt > 1 ) {
-            g_mutex_lock ( &mutex );
-            while ( count > 0 ) {
-                g_cond_wait ( &cond, &mutex );
+        for ( const char *p = str; *p != '\0'; p++ ) {
+            const char *next = p;
+            if ( job->method == MM_NORMAL ) {
+                gboolean found = job->case_sensitive ? strncmp ( p, word, wlen ) == 0 : g_ascii_strncasecmp ( p, word, wlen ) == 0;
+                if ( !found ) {
+                    continue;
+                }
+                next = p + wlen;
+            }
+            unsigned char c = job->case_sensitive ? *next : g_ascii_tolower ( *next );
+            if ( c < 128 && g_ascii_isgraph ( c ) && !seen[c] ) {
+                seen[c] = TRUE;
+                counts[c]++;
             }
-            g_mutex_unlock ( &mutex );
         }
-        g_cond_clear ( &cond );
-        g_mutex_clear ( &mutex );
-        for ( unsigned int i = 0; i < nt; i++ ) {
-            if ( j != states[i].start ) {
-                memmove ( &( state->line_map[j] ), &( state->line_map[states[i].start] ), sizeof ( unsigned int ) * ( states[i].count ) );
+    }
+    GString *chars = g_string_new ( NULL );
+    while ( chars->len < FILTER_SPECULATE_CHARS ) {
+        unsigned int best = 0;
+        for ( unsigned int c = 1; c < 128; c++ ) {
+            if ( counts[c] > counts[best] ) {
+                best = c;
             }
-            j += states[i].count;
         }
-        if ( config.sort ) {
-            g_qsort_with_data ( state->line_map, j, sizeof ( int ), lev_sort, state->distance );
+        if ( counts[best] == 0 ) {
+            break;
+        }
+        g_string_append_c ( chars, (gchar) best );
+        counts[best] = 0;
+    }
+    if ( chars->len == 0 ) {
+        g_string_free ( chars, TRUE );
+        return NULL;
+    }
+    return g_string_free ( chars, FALSE );
+}
+
+/**
+ * Start the speculative filter job for the next character, if any are left.
+ * They run one after the other on the background thread, so a real filter job never waits long for it.
+ */
+static void rofi_view_speculate_next ( void )
+{
+    RofiViewState *state = CacheState.speculate_view;
+    while ( state != NULL && CacheState.speculate_chars[0] != '\0' ) {
+        gchar      *text = g_strdup_printf ( "%s%c", CacheState.speculate_text, CacheState.speculate_chars[0] );
+        filter_job *job  = rofi_view_filter_job_new ( state, text );
+        g_free ( text );
+        memmove ( CacheState.speculate_chars, CacheState.speculate_chars + 1, strlen ( CacheState.speculate_chars ) );
+        if ( job->cached || !job->plain ) {
+            rofi_view_filter_job_free ( job );
+            continue;
         }
+        // Leave building the index and folded strings to the real jobs.
+        job->build_index = FALSE;
+        job->build_fold  = FALSE;
+        rofi_view_filter_job_detach ( job );
+        g_debug ( "Speculative filter on '%s': %u rows.", job->text, job->num_candidates );
+        CacheState.speculate = job;
+        g_thread_pool_push ( tpool, job, NULL );
+        return;
+    }
+    rofi_view_speculate_cancel ();
+}
 
-        // Cleanup + bookkeeping.
-        state->filtered_lines = j;
-        g_free ( pattern );
+/**
+ * @param state The Menu Handle
+ * @param job The job that just got applied.
+ *
+ * While the user thinks about the next key, filter on the characters most likely typed next.
+ * The results go into the result cache of the view, so when one of them is typed it is shown right away.
+ * Only done when the next filter would run in the background anyway, the result cache bounds the memory used.
+ */
+static void rofi_view_speculate_start ( RofiViewState *state, const filter_job *job )
+{
+    rofi_view_speculate_cancel ();
+    if ( !config.speculate || tpool == NULL || config.auto_select || !state->rows_stable ) {
+        return;
+    }
+    if ( !job->plain || job->method == MM_REGEX || job->filtered_lines < FILTER_ASYNC_MIN_ROWS || state->last_filter == NULL ) {
+        return;
+    }
+    CacheState.speculate_chars = rofi_view_speculate_pick ( state, job );
+    if ( CacheState.speculate_chars == NULL ) {
+        return;
+    }
+    CacheState.speculate_view = state;
+    CacheState.speculate_text = g_strdup ( job->text );
+    rofi_view_speculate_next ();
+}
+
+static void rofi_view_refilter ( RofiViewState *state )
+{
+    TICK_N ( "Filter start" );
+    // A speculative job for exactly this input becomes the real one.
+    filter_job *speculative = NULL;
+    if ( !state->reload && rofi_view_speculate_matches ( state ) ) {
+        speculative          = CacheState.speculate;
+        CacheState.speculate = NULL;
+    }
+    // Whatever is still running or waiting is for an outdated input.
+    rofi_view_filter_cancel_pending ();
+    if ( CacheState.refilter_timeout > 0 ) {
+        g_source_remove ( CacheState.refilter_timeout );
+        CacheState.refilter_timeout = 0;
+    }
+    state->refilter = FALSE;
+    if ( speculative != NULL ) {
+        g_debug ( "Taking over speculative filter on '%s'.", speculative->text );
+        CacheState.filter = speculative;
+        return;
+    }
+    if ( state->reload ) {
+        _rofi_view_reload_row ( state );
+        state->reload = FALSE;
+        // Rows changed, previous result is no longer valid.
+        g_free ( state->last_filter );
+        state->last_filter = NULL;
+    }
+    if ( strlen ( state->text->text ) > 0 ) {
+        filter_job *job = rofi_view_filter_job_new ( state, state->text->text );
+        /**
+         * Filter big lists in the background, so key presses and redraws are handled meanwhile.
+         * The old result stays visible until the new one lands.
+         * With auto-select the result decides if we quit, so wait for it.
+         */
+        if ( !job->cached && tpool != NULL && !config.auto_select && ( job->num_candidates >= FILTER_ASYNC_MIN_ROWS || job->build_index || job->build_fold ) ) {
+            rofi_view_filter_job_detach ( job );
+            CacheState.filter = job;
+            g_thread_pool_push ( tpool, job, NULL );
+            return;
+        }
+        if ( !job->cached ) {
+            rofi_view_filter_job_run ( job );
+        }
+        rofi_view_filter_job_apply ( state, job );
+        rofi_view_filter_job_free ( job );
     }
     else{
+        if ( state->tokens ) {
+            tokenize_free ( state->tokens );
+            state->tokens = NULL;
+        }
+        rofi_view_match_spans_clear ( state );
+        g_free ( state->last_filter );
+        state->last_filter = NULL;
         for ( unsigned int i = 0; i < state->num_lines; i++ ) {
             state->line_map[i] = i;
         }
         state->filtered_lines = state->num_lines;
+        state->sorted_lines   = state->num_lines;
+        rofi_view_refilter_done ( state );
     }
-    listview_set_num_elements ( state->list_view, state->filtered_lines );
+}
 
-    if ( config.auto_select == TRUE && state->filtered_lines == 1 && state->num_lines > 1 ) {
-        ( state->selected_line ) = state->line_map[listview_get_selected ( state->list_view  )];
-        state->retv              = MENU_OK;
-        state->quit              = TRUE;
+/**
+ * @param state The Menu Handle
+ *
+ * Make sure line_map reflects the current input, before acting on the selected row.
+ */
+static void rofi_view_filter_flush ( RofiViewState *state )
+{
+    if ( state->refilter ) {
+        rofi_view_refilter ( state );
     }
-    // Size the window.
-    int height = rofi_view_calculate_height ( state );
-    if ( height != state->height ) {
-        state->height = height;
-        rofi_view_calculate_window_position ( state );
-        rofi_view_window_update_size ( state );
-        g_debug ( "Resize based on re-filter" );
+    filter_job *job = CacheState.filter;
+    if ( job != NULL && job->state == state ) {
+        CacheState.filter = NULL;
+        rofi_view_filter_job_wait ( job );
+        rofi_view_filter_job_apply ( state, job );
+        rofi_view_filter_job_free ( job );
     }
-    state->refilter = FALSE;
-    TICK_N ( "Filter done" );
+}
+
+/**
+ * @param state The Menu Handle
+ *
+ * The mode added rows after the ones the view has. Only filter the new rows and add their matches to
+ * the shown result, filtering all rows again on every block of e.g. dmenu input would be quadratic.
+ * The rows are filtered in the main thread, split over the workers: a block is short next to all rows.
+ *
+ * @returns FALSE if the shown result is not for the current input and rows, the view then has to reload.
+ */
+static gboolean rofi_view_append_rows ( RofiViewState *state )
+{
+    unsigned int old_lines = state->num_lines;
+    unsigned int num_lines = mode_get_num_entries ( state->sw );
+    // A pending re-filter means the shown result is for an older input.
+    if ( state->reload || state->refilter || num_lines < old_lines || ( CacheState.filter != NULL && CacheState.filter->state != state ) ) {
+        return FALSE;
+    }
+    // A running filter job is for the current input and the old rows, finish it and add to its result.
+    rofi_view_filter_flush ( state );
+    // Speculative and cached results, index and folded strings do not know the new rows.
+    // The shown result stays valid, so last_filter is kept for narrowing on the next key press.
+    rofi_view_speculate_cancel ();
+    rofi_view_result_cache_clear ( state );
+    rofi_trigram_index_free ( state->trigram );
+    rofi_fold_corpus_free ( state->folded );
+    state->trigram     = NULL;
+    state->folded      = NULL;
+    state->rows_stable = FALSE;
+    rofi_view_rows_reserve ( state, num_lines );
+    state->num_lines = num_lines;
+    listview_set_max_lines ( state->list_view, state->num_lines );
+    rofi_view_reload_message_bar ( state );
+
+    if ( strlen ( state->text->text ) == 0 ) {
+        for ( unsigned int i = old_lines; i < num_lines; i++ ) {
+            state->line_map[state->filtered_lines++] = i;
+        }
+        state->sorted_lines = state->filtered_lines;
+    }
+    else if ( num_lines > old_lines ) {
+        filter_job *job = rofi_view_filter_job_prepare ( state, state->text->text );
+        job->first_row      = old_lines;
+        job->num_candidates = num_lines - old_lines;
+        // The new rows get their distance next to those of the rows already shown.
+        job->distance = job->sort ? state->distance : NULL;
+        rofi_view_filter_job_run ( job );
+        job->distance = NULL;
+        if ( job->filtered_lines > 0 ) {
+            memcpy ( &( state->line_map[state->filtered_lines] ), job->line_map, job->filtered_lines * sizeof ( unsigned int ) );
+        }
+        if ( job->sort ) {
+            state->sorted_lines = rofi_sort_append ( state->line_map, state->filtered_lines, state->sorted_lines,
+                                                     job->filtered_lines, job->sorted_lines, state->distance );
+        }
+        else {
+            state->sorted_lines += job->filtered_lines;
+        }
+        state->filtered_lines += job->filtered_lines;
+        g_debug ( "Filtered %u appended rows: %u matches.", num_lines - old_lines, job->filtered_lines );
+        rofi_view_filter_job_free ( job );
+    }
+    rofi_view_refilter_done ( state );
+    return TRUE;
+}
+
+static gboolean rofi_view_refilter_timeout ( G_GNUC_UNUSED gpointer data )
+{
+    CacheState.refilter_timeout = 0;
+    if ( current_active_menu && current_active_menu->refilter ) {
+        rofi_view_refilter ( current_active_menu );
+        rofi_view_queue_redraw ();
+    }
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * @param state The Menu Handle
+ *
+ * Re-filter after the input changed. On lists longer than the lazy filter limit this is delayed
+ * and restarted on every key press, so a burst of typing results in a single re-filter.
+ * The delay follows the cost of the last re-filter: no point in starting the next one sooner
+ * than the previous one took.
+ */
+static void rofi_view_refilter_lazy ( RofiViewState *state )
+{
+    // The user is typing, so the rows are not changing under us: worth indexing.
+    state->rows_stable = TRUE;
+    // Speculative work for another input only holds up the background thread now.
+    if ( !rofi_view_speculate_matches ( state ) ) {
+        rofi_view_speculate_cancel ();
+    }
+    // With auto-select the result decides if we quit, that is only checked on the next event.
+    // A cached result costs nothing, so show it right away.
+    if ( config.lazy_filter_limit == 0 || state->num_lines <= config.lazy_filter_limit || config.auto_select ||
+         rofi_view_result_cache_find ( state, state->text->text ) != NULL || CacheState.speculate != NULL ) {
+        rofi_view_refilter ( state );
+        return;
+    }
+    if ( CacheState.refilter_timeout > 0 ) {
+        g_source_remove ( CacheState.refilter_timeout );
+    }
+    guint delay = CLAMP ( CacheState.refilter_cost / 1000, LAZY_FILTER_MIN_DELAY, LAZY_FILTER_MAX_DELAY );
+    CacheState.refilter_timeout = g_timeout_add ( delay, rofi_view_refilter_timeout, NULL );
 }
 /**
  * @param state The Menu Handle
@@ -1142,14 +2306,43 @@ static void rofi_view_refilter ( RofiViewState *state )
 void process_result ( RofiViewState *state );
 void rofi_view_finalize ( RofiViewState *state )
 {
+    // The mode can be changed or destroyed from here on, stop using it.
+    if ( state && ( ( CacheState.filter != NULL && CacheState.filter->state == state ) || CacheState.speculate_view == state ) ) {
+        rofi_view_filter_cancel_pending ();
+    }
     if ( state && state->finalize != NULL ) {
         state->finalize ( state );
     }
 }
 
+/**
+ * @param action The action
+ *
+ * @returns TRUE if the action acts on the selected row and so needs the result for the current input.
+ */
+static gboolean rofi_view_action_needs_result ( KeyBindingAction action )
+{
+    switch ( action )
+    {
+    case DELETE_ENTRY:
+    case ROW_TAB:
+    case ROW_SELECT:
+    case ACCEPT_ALT:
+    case ACCEPT_ENTRY:
+        return TRUE;
+    default:
+        break;
+    }
+    return ( action >= SELECT_ELEMENT_1 && action <= SELECT_ELEMENT_10 ) || ( action >= CUSTOM_1 && action <= CUSTOM_19 );
+}
+
 gboolean rofi_view_trigger_action ( RofiViewState *state, KeyBindingAction action )
 {
     gboolean ret = TRUE;
+    // Wait for a filter still running in the background.
+    if ( rofi_view_action_needs_result ( action ) ) {
+        rofi_view_filter_flush ( state );
+    }
     switch ( action )
     {
     // Handling of paste
@@ -1168,6 +2361,8 @@ gboolean rofi_view_trigger_action ( RofiViewState *state, KeyBindingAction actio
         break;
     case TOGGLE_SORT:
         if ( state->case_indicator != NULL ) {
+            // A running filter is for the old setting, stop it instead of waiting for it.
+            rofi_view_cancel_filter ();
             config.sort     = !config.sort;
             state->refilter = TRUE;
             textbox_text ( state->case_indicator, get_matching_state () );
@@ -1187,6 +2382,7 @@ gboolean rofi_view_trigger_action ( RofiViewState *state, KeyBindingAction actio
     // Toggle case sensitivity.
     case TOGGLE_CASE_SENSITIVITY:
         if ( state->case_indicator != NULL ) {
+            rofi_view_cancel_filter ();
             config.case_sensitive    = !config.case_sensitive;
             ( state->selected_line ) = 0;
             state->refilter          = TRUE;
@@ -1198,7 +2394,7 @@ gboolean rofi_view_trigger_action ( RofiViewState *state, KeyBindingAction actio
     {
         unsigned int selected = listview_get_selected ( state->list_view );
         if ( selected < state->filtered_lines ) {
-            ( state->selected_line ) = state->line_map[selected];
+            ( state->selected_line ) = rofi_view_filtered_line ( state, selected );
             state->retv              = MENU_ENTRY_DELETE;
             state->quit              = TRUE;
         }
@@ -1220,7 +2416,7 @@ gboolean rofi_view_trigger_action ( RofiViewState *state, KeyBindingAction actio
     {
         unsigned int index = action - SELECT_ELEMENT_1;
         if ( index < state->filtered_lines ) {
-            state->selected_line = state->line_map[index];
+            state->selected_line = rofi_view_filtered_line ( state, index );
             state->retv          = MENU_OK;
             state->quit          = TRUE;
         }
@@ -1249,7 +2445,7 @@ gboolean rofi_view_trigger_action ( RofiViewState *state, KeyBindingAction actio
         state->selected_line = UINT32_MAX;
         unsigned int selected = listview_get_selected ( state->list_view );
         if ( selected < state->filtered_lines ) {
-            ( state->selected_line ) = state->line_map[selected];
+            ( state->selected_line ) = rofi_view_filtered_line ( state, selected );
         }
         state->retv = MENU_QUICK_SWITCH | ( ( action - CUSTOM_1 ) & MENU_LOWER_MASK );
         state->quit = TRUE;
@@ -1320,7 +2516,7 @@ gboolean rofi_view_trigger_action ( RofiViewState *state, KeyBindingAction actio
         unsigned int selected = listview_get_selected ( state->list_view );
         state->selected_line = UINT32_MAX;
         if ( selected < state->filtered_lines ) {
-            ( state->selected_line ) = state->line_map[selected];
+            ( state->selected_line ) = rofi_view_filtered_line ( state, selected );
             state->retv              = MENU_OK;
         }
         else {
@@ -1344,7 +2540,7 @@ gboolean rofi_view_trigger_action ( RofiViewState *state, KeyBindingAction actio
         unsigned int selected = listview_get_selected ( state->list_view );
         state->selected_line = UINT32_MAX;
         if ( selected < state->filtered_lines ) {
-            ( state->selected_line ) = state->line_map[selected];
+            ( state->selected_line ) = rofi_view_filtered_line ( state, selected );
             state->retv              = MENU_OK;
         }
         else {
@@ -1511,7 +2707,7 @@ void rofi_view_itterrate ( RofiViewState *state, xcb_generic_event_t *event, xkb
     }
     // Update if requested.
     if ( state->refilter ) {
-        rofi_view_refilter ( state );
+        rofi_view_refilter_lazy ( state );
     }
     rofi_view_update ( state, TRUE );
 
@@ -1551,11 +2747,13 @@ static void rofi_view_listview_mouse_activated_cb ( listview *lv, xcb_button_pre
 {
     RofiViewState *state  = (RofiViewState *) udata;
     int           control = x11_modifier_active ( xce->state, X11MOD_CONTROL );
+    // The clicked row is one of the shown rows, do not let a pending result replace them.
+    rofi_view_filter_cancel_pending ();
     state->retv = MENU_OK;
     if ( control ) {
         state->retv |= MENU_CUSTOM_ACTION;
     }
-    ( state->selected_line ) = state->line_map[listview_get_selected ( lv )];
+    ( state->selected_line ) = rofi_view_filtered_line ( state, listview_get_selected ( lv ) );
     // Quit
     state->quit        = TRUE;
     state->skip_absorb = TRUE;
@@ -1653,8 +2851,7 @@ RofiViewState *rofi_view_create ( Mode *sw,
     box_add ( state->main_box, WIDGET ( state->list_view ), TRUE, 3 );
 
     // filtered list
-    state->line_map = g_malloc0_n ( state->num_lines, sizeof ( unsigned int ) );
-    state->distance = (int *) g_malloc0_n ( state->num_lines, sizeof ( int ) );
+    rofi_view_rows_reserve ( state, state->num_lines );
 
     rofi_view_calculate_window_width ( state );
     // Need to resize otherwise calculated desired height is wrong.
@@ -1739,6 +2936,10 @@ void rofi_view_cleanup ()
         g_source_remove ( CacheState.idle_timeout );
         CacheState.idle_timeout = 0;
     }
+    if ( CacheState.refilter_timeout > 0 ) {
+        g_source_remove ( CacheState.refilter_timeout );
+        CacheState.refilter_timeout = 0;
+    }
     if ( CacheState.repaint_source > 0 ) {
         g_source_remove ( CacheState.repaint_source );
         CacheState.repaint_source = 0;
@@ -1782,12 +2983,10 @@ void rofi_view_workers_initialize ( void )
     }
     // Create thread pool
     GError *error = NULL;
-    tpool = g_thread_pool_new ( rofi_view_call_thread, NULL, config.threads, FALSE, &error );
+    rofi_parallel_init ( config.threads, &error );
     if ( error == NULL ) {
-        // Idle threads should stick around for a max of 60 seconds.
-        g_thread_pool_set_max_idle_time ( 60000 );
-        // We are allowed to have
-        g_thread_pool_set_max_threads ( tpool, config.threads, &error );
+        // One thread to run the filter in the background, it hands the work to the parallel workers.
+        tpool = g_thread_pool_new ( rofi_view_filter_job_thread, NULL, 1, FALSE, &error );
     }
     // If error occured during setup of pool, tell user and exit.
     if ( error != NULL ) {
@@ -1799,10 +2998,12 @@ void rofi_view_workers_initialize ( void )
 }
 void rofi_view_workers_finalize ( void )
 {
+    rofi_view_filter_cancel_pending ();
     if ( tpool ) {
         g_thread_pool_free ( tpool, TRUE, TRUE );
         tpool = NULL;
     }
+    rofi_parallel_cleanup ();
 }
 Mode * rofi_view_get_mode ( RofiViewState *state )
 {
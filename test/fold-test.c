@@ -0,0 +1,111 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <assert.h>
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parallel.h"
+#include "fold.h"
+
+static int test = 0;
+
+#define TASSERT( a )        {                            \
+        assert ( a );                                    \
+        printf ( "Test %i passed (%s)\n", ++test, # a ); \
+}
+
+static const char *fold_test_text ( unsigned int row, gpointer user_data )
+{
+    const char **rows = (const char * *) user_data;
+    return rows[row];
+}
+
+static const char *fold_test_generated ( unsigned int row, gpointer user_data )
+{
+    GPtrArray *rows = (GPtrArray *) user_data;
+    return g_ptr_array_index ( rows, row );
+}
+
+int main ( G_GNUC_UNUSED int argc, G_GNUC_UNUSED char **argv )
+{
+    const char     *rows[] = {
+        "Firefox",
+        "",
+        NULL,
+        "ÉÉN Één één",
+        // KELVIN SIGN folds to a shorter 'k'.
+        "Kelvin",
+        "ΣΊΣΥΦΟΣ",
+        // Not valid UTF-8.
+        "\xff\xfe",
+    };
+    RofiFoldCorpus *corpus = rofi_fold_corpus_new ( G_N_ELEMENTS ( rows ), fold_test_text, rows, NULL );
+    TASSERT ( corpus != NULL );
+    TASSERT ( g_strcmp0 ( rofi_fold_corpus_get ( corpus, 0 ), "firefox" ) == 0 );
+    TASSERT ( g_strcmp0 ( rofi_fold_corpus_get ( corpus, 1 ), "" ) == 0 );
+    TASSERT ( rofi_fold_corpus_get ( corpus, 2 ) == NULL );
+    TASSERT ( g_strcmp0 ( rofi_fold_corpus_get ( corpus, 3 ), "één één één" ) == 0 );
+    TASSERT ( rofi_fold_corpus_get ( corpus, 4 ) == NULL );
+    TASSERT ( g_strcmp0 ( rofi_fold_corpus_get ( corpus, 5 ), "σίσυφοσ" ) == 0 );
+    TASSERT ( rofi_fold_corpus_get ( corpus, 6 ) == NULL );
+    TASSERT ( rofi_fold_corpus_get ( corpus, G_N_ELEMENTS ( rows ) ) == NULL );
+    // Byte offsets are kept.
+    TASSERT ( strlen ( rofi_fold_corpus_get ( corpus, 3 ) ) == strlen ( rows[3] ) );
+    rofi_fold_corpus_free ( corpus );
+
+    corpus = rofi_fold_corpus_new ( 0, fold_test_text, rows, NULL );
+    TASSERT ( corpus != NULL );
+    TASSERT ( rofi_fold_corpus_get ( corpus, 0 ) == NULL );
+    rofi_fold_corpus_free ( corpus );
+
+    // Cancelled before it started.
+    gint cancel = TRUE;
+    TASSERT ( rofi_fold_corpus_new ( G_N_ELEMENTS ( rows ), fold_test_text, rows, &cancel ) == NULL );
+
+    // Spread over the workers, every row ends up in its own place.
+    TASSERT ( rofi_parallel_init ( 4, NULL ) );
+    GPtrArray *generated = g_ptr_array_new_with_free_func ( g_free );
+    for ( unsigned int i = 0; i < 100000; i++ ) {
+        g_ptr_array_add ( generated, g_strdup_printf ( "Row %u ÄÖÜ", i ) );
+    }
+    corpus = rofi_fold_corpus_new ( generated->len, fold_test_generated, generated, NULL );
+    TASSERT ( corpus != NULL );
+    gboolean same = TRUE;
+    for ( unsigned int i = 0; i < generated->len; i++ ) {
+        char *expected = g_strdup_printf ( "row %u äöü", i );
+        same = same && g_strcmp0 ( rofi_fold_corpus_get ( corpus, i ), expected ) == 0;
+        g_free ( expected );
+    }
+    TASSERT ( same );
+    rofi_fold_corpus_free ( corpus );
+    g_ptr_array_free ( generated, TRUE );
+    rofi_parallel_cleanup ();
+    return EXIT_SUCCESS;
+}
@@ -51,6 +51,53 @@ struct xcb_stuff *xcb;
             abort ( );                                                                   \
         }                                                                                \
 }
+/**
+ * The classic column based levenshtein, used to check the bit-parallel implementation.
+ */
+static unsigned int levenshtein_reference ( const char *needle, const glong needlelen, const char *haystack, const glong haystacklen )
+{
+    unsigned int column[needlelen + 1];
+    for ( glong y = 0; y <= needlelen; y++ ) {
+        column[y] = y;
+    }
+    for ( glong x = 1; x <= haystacklen; x++ ) {
+        const char *needles = needle;
+        column[0] = x;
+        gunichar   haystackc = g_utf8_get_char ( haystack );
+        if ( !config.case_sensitive ) {
+            haystackc = g_unichar_tolower ( g_unichar_toupper ( haystackc ) );
+        }
+        for ( glong y = 1, lastdiag = x - 1; y <= needlelen; y++ ) {
+            gunichar needlec = g_utf8_get_char ( needles );
+            if ( !config.case_sensitive ) {
+                needlec = g_unichar_tolower ( g_unichar_toupper ( needlec ) );
+            }
+            unsigned int olddiag = column[y];
+            column[y] = MIN ( MIN ( column[y] + 1, column[y - 1] + 1 ), lastdiag + ( needlec == haystackc ? 0 : 1 ) );
+            lastdiag  = olddiag;
+            needles   = g_utf8_next_char ( needles );
+        }
+        haystack = g_utf8_next_char ( haystack );
+    }
+    return column[needlelen];
+}
+
+/**
+ * @param rand   Random source.
+ * @param length Number of characters.
+ *
+ * @returns random string from a small alphabet, mixing ASCII and non-ASCII characters.
+ */
+static char *levenshtein_random_string ( GRand *rand, int length )
+{
+    const char * const alphabet[] = { "a", "b", "c", "A", "B", " ", "k", "é", "É", "\u212A", "\u2603" };
+    GString            *str       = g_string_new ( "" );
+    for ( int i = 0; i < length; i++ ) {
+        g_string_append ( str, alphabet[g_rand_int_range ( rand, 0, G_N_ELEMENTS ( alphabet ) )] );
+    }
+    return g_string_free ( str, FALSE );
+}
+
 void rofi_add_error_message ( GString *msg )
 {
 
@@ -109,6 +156,106 @@ int main ( int argc, char ** argv )
     TASSERTE ( levenshtein ( "aap", g_utf8_strlen ( "aap", -1), "noot aap mies", g_utf8_strlen ( "noot aap mies", -1) ), 10 );
     TASSERTE ( levenshtein ( "noot aap mies", g_utf8_strlen ( "noot aap mies", -1), "aap", g_utf8_strlen ( "aap", -1) ), 10 );
     TASSERTE ( levenshtein ( "otp", g_utf8_strlen ( "otp", -1), "noot aap", g_utf8_strlen ( "noot aap", -1) ), 5 );
+    TASSERTE ( levenshtein ( "", 0, "noot aap", g_utf8_strlen ( "noot aap", -1) ), 8 );
+    TASSERTE ( levenshtein ( "noot", g_utf8_strlen ( "noot", -1), "", 0 ), 4 );
+    config.case_sensitive = FALSE;
+    TASSERTE ( levenshtein ( "NOOT", g_utf8_strlen ( "NOOT", -1), "noot", g_utf8_strlen ( "noot", -1) ), 0 );
+    TASSERTE ( levenshtein ( "één", g_utf8_strlen ( "één", -1), "ÉÉN", g_utf8_strlen ( "ÉÉN", -1) ), 0 );
+    TASSERTE ( levenshtein ( "kelvin", g_utf8_strlen ( "kelvin", -1), "\u212Aelvin", g_utf8_strlen ( "\u212Aelvin", -1) ), 0 );
+    config.case_sensitive = TRUE;
+    TASSERTE ( levenshtein ( "NOOT", g_utf8_strlen ( "NOOT", -1), "noot", g_utf8_strlen ( "noot", -1) ), 4 );
+    TASSERTE ( levenshtein ( "één", g_utf8_strlen ( "één", -1), "ÉÉN", g_utf8_strlen ( "ÉÉN", -1) ), 3 );
+    config.case_sensitive = FALSE;
+    /**
+     * Compare the bit-parallel levenshtein against the reference, with needles
+     * fitting one word, and needles needing multiple words.
+     */
+    {
+        GRand *rand = g_rand_new_with_seed ( 1234 );
+        for ( int needle_max = 8; needle_max <= 256; needle_max *= 4 ) {
+            unsigned int errors = 0;
+            for ( int i = 0; i < 500; i++ ) {
+                char  *needle   = levenshtein_random_string ( rand, g_rand_int_range ( rand, 0, needle_max ) );
+                char  *haystack = levenshtein_random_string ( rand, g_rand_int_range ( rand, 0, 100 ) );
+                glong nlen      = g_utf8_strlen ( needle, -1 );
+                glong hlen      = g_utf8_strlen ( haystack, -1 );
+                config.case_sensitive = g_rand_boolean ( rand );
+                if ( levenshtein ( needle, nlen, haystack, hlen ) != levenshtein_reference ( needle, nlen, haystack, hlen ) ) {
+                    errors++;
+                }
+                g_free ( needle );
+                g_free ( haystack );
+            }
+            TASSERTE ( errors, 0u );
+        }
+        config.case_sensitive = FALSE;
+        g_rand_free ( rand );
+    }
+    /**
+     * Prepared needle, reused for multiple haystacks.
+     */
+    {
+        LevenshteinNeedle *n = levenshtein_needle_new ( "aap", 3, FALSE );
+        TASSERTE ( levenshtein_needle_distance ( n, "aap", 3 ), 0 );
+        TASSERTE ( levenshtein_needle_distance ( n, "AAP noot", 8 ), 5 );
+        TASSERTE ( levenshtein_needle_distance ( n, "noot aap mies", 13 ), 10 );
+        levenshtein_needle_free ( n );
+    }
+    /**
+     * Fuzzy scorer: entries that do not contain the pattern get the no-match score.
+     */
+    {
+        int no_match = rofi_scorer_fuzzy_evaluate ( "ab1", 3, "", 0, FALSE );
+        TASSERT ( rofi_scorer_fuzzy_evaluate ( "ab1", 3, "b-ab", 4, FALSE ) == no_match );
+        TASSERT ( rofi_scorer_fuzzy_evaluate ( "ap", 2, "pa", 2, FALSE ) == no_match );
+        TASSERT ( rofi_scorer_fuzzy_evaluate ( "ap", 2, "a noot p", 8, FALSE ) < no_match );
+        TASSERT ( rofi_scorer_fuzzy_evaluate ( "ap", 2, "a\np", 3, FALSE ) == no_match );
+        TASSERT ( rofi_scorer_fuzzy_evaluate ( "ap", 2, "a\nap", 4, FALSE ) < no_match );
+    }
+    /**
+     * Pre-folded haystacks give the same result as folding while matching.
+     */
+    {
+        LevenshteinNeedle *n = levenshtein_needle_new ( "ÉÉN aap", 7, FALSE );
+        TASSERTE ( levenshtein_needle_distance_folded ( n, "één aap", 7 ), levenshtein_needle_distance ( n, "ÉÉN AAP", 7 ) );
+        TASSERTE ( levenshtein_needle_distance_folded ( n, "één noot", 8 ), levenshtein_needle_distance ( n, "Één Noot", 8 ) );
+        levenshtein_needle_free ( n );
+        TASSERT ( rofi_scorer_fuzzy_evaluate_folded ( "ÉN", 2, "ÉÉN", "één", 3, FALSE ) == rofi_scorer_fuzzy_evaluate ( "ÉN", 2, "ÉÉN", 3, FALSE ) );
+        TASSERT ( rofi_scorer_fuzzy_evaluate_folded ( "an", 2, "AapNoot", "aapnoot", 7, FALSE ) == rofi_scorer_fuzzy_evaluate ( "an", 2, "AapNoot", 7, FALSE ) );
+    }
+    /**
+     * The scorer folds as asked by the caller, not by the current setting.
+     */
+    {
+        int no_match = rofi_scorer_fuzzy_evaluate ( "an", 2, "", 0, FALSE );
+        config.case_sensitive = TRUE;
+        TASSERT ( rofi_scorer_fuzzy_evaluate ( "an", 2, "AapNoot", 7, FALSE ) < no_match );
+        config.case_sensitive = FALSE;
+        TASSERT ( rofi_scorer_fuzzy_evaluate ( "an", 2, "AapNoot", 7, TRUE ) == no_match );
+        TASSERT ( rofi_scorer_fuzzy_evaluate_folded ( "an", 2, "AapNoot", "aapnoot", 7, TRUE ) == no_match );
+    }
+    /**
+     * Fuzzy scorer, lower is better.
+     */
+    {
+        const char *p       = "ap";
+        int        no_match = rofi_scorer_fuzzy_evaluate ( p, 2, "pa", 2, FALSE );
+        TASSERT ( rofi_scorer_fuzzy_evaluate ( p, 2, "ap", 2, FALSE ) < rofi_scorer_fuzzy_evaluate ( p, 2, "xaxxp", 5, FALSE ) );
+        TASSERT ( rofi_scorer_fuzzy_evaluate ( p, 2, "noot ap", 7, FALSE ) < rofi_scorer_fuzzy_evaluate ( p, 2, "nootap", 6, FALSE ) );
+        TASSERT ( rofi_scorer_fuzzy_evaluate ( p, 2, "a noot p", 8, FALSE ) < no_match );
+        // Entries longer then the scored window still get a score.
+        GString *str = g_string_new ( "" );
+        for ( int i = 0; i < 100; i++ ) {
+            g_string_append ( str, "noot mies " );
+        }
+        g_string_append ( str, "aap" );
+        TASSERT ( rofi_scorer_fuzzy_evaluate ( p, 2, str->str, g_utf8_strlen ( str->str, -1 ), FALSE ) < no_match );
+        g_string_prepend ( str, "a" );
+        TASSERT ( rofi_scorer_fuzzy_evaluate ( "ax", 2, str->str, g_utf8_strlen ( str->str, -1 ), FALSE ) == no_match );
+        g_string_append ( str, "x" );
+        TASSERT ( rofi_scorer_fuzzy_evaluate ( "ax", 2, str->str, g_utf8_strlen ( str->str, -1 ), FALSE ) < no_match );
+        g_string_free ( str, TRUE );
+    }
     /**
      * Quick converision check.
      */
@@ -30,6 +30,7 @@
 #include <glib.h>
 #include <stdio.h>
 #include <helper.h>
+#include <helper-theme.h>
 #include <string.h>
 #include <xcb/xcb_ewmh.h>
 #include "xcb-internal.h"
@@ -75,7 +76,7 @@ int main ( int argc, char ** argv )
     }
     {
         config.matching_method = MM_NORMAL;
-        GRegex **tokens = tokenize ( "noot", FALSE );
+        rofi_int_matcher **tokens = tokenize ( "noot", FALSE );
 
         TASSERT ( helper_token_match ( tokens, "aap noot mies") == TRUE );
         TASSERT ( helper_token_match ( tokens, "aap mies") == FALSE );
@@ -105,10 +106,43 @@ int main ( int argc, char ** argv )
         TASSERT ( helper_token_match ( tokens, "nootap mies") == TRUE );
         TASSERT ( helper_token_match ( tokens, "noap miesot") == TRUE );
         tokenize_free ( tokens );
+
+        // Entries long enough to go through the vectorized search.
+        tokens = tokenize ( "Noot", FALSE );
+        TASSERT ( helper_token_match ( tokens, "aap mies aap mies aap mies aap mies aap mies NOOT") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "aap mies aap mies aap mies aap mies aap mies NOO") == FALSE );
+        TASSERT ( helper_token_match ( tokens, "aap mies aap mies aap nOoT aap mies aap mies aap mies") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "aap mies aap mies aap nootaap mies aap mies aap mies") == TRUE );
+        tokenize_free ( tokens );
+        tokens = tokenize ( "n[t", FALSE );
+        TASSERT ( helper_token_match ( tokens, "aap mies aap mies aap N[T aap mies aap mies aap mies") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "aap mies aap mies aap N{T aap mies aap mies aap mies") == FALSE );
+        tokenize_free ( tokens );
+
+        // Non-ASCII needles.
+        tokens = tokenize ( "één", FALSE );
+        TASSERT ( helper_token_match ( tokens, "aap één mies") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "aap ÉÉN mies") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "aap een mies") == FALSE );
+        tokenize_free ( tokens );
+        tokens = tokenize ( "één", TRUE );
+        TASSERT ( helper_token_match ( tokens, "aap één mies") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "aap ÉÉN mies") == FALSE );
+        tokenize_free ( tokens );
+
+        // k and s fold to KELVIN SIGN and LATIN SMALL LETTER LONG S.
+        tokens = tokenize ( "kelvin", FALSE );
+        TASSERT ( helper_token_match ( tokens, "100 \u212Aelvin") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "100 KELVIN") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "100 celvin") == FALSE );
+        tokenize_free ( tokens );
+        tokens = tokenize ( "kelvin", TRUE );
+        TASSERT ( helper_token_match ( tokens, "100 \u212Aelvin") == FALSE );
+        tokenize_free ( tokens );
     }
     {
         config.matching_method = MM_GLOB;
-        GRegex **tokens = tokenize ( "noot", FALSE );
+        rofi_int_matcher **tokens = tokenize ( "noot", FALSE );
 
         TASSERT ( helper_token_match ( tokens, "aap noot mies") == TRUE );
         TASSERT ( helper_token_match ( tokens, "aap mies") == FALSE );
@@ -162,10 +196,85 @@ int main ( int argc, char ** argv )
         TASSERT ( helper_token_match ( tokens, "noap miesot") == TRUE);
         TASSERT ( helper_token_match ( tokens, "ot nap mies") == TRUE);
         tokenize_free ( tokens );
+
+        // '?' is one character, not one byte, and never white space. '*' stays on one line.
+        tokens = tokenize ( "n?ot", FALSE );
+        TASSERT ( helper_token_match ( tokens, "aap nÖot mies") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "aap n ot mies") == FALSE );
+        tokenize_free ( tokens );
+        tokens = tokenize ( "a*b*c", FALSE );
+        TASSERT ( helper_token_match ( tokens, "xaxbxcx") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "xaxcxbx") == FALSE );
+        TASSERT ( helper_token_match ( tokens, "aab\nbc") == FALSE );
+        TASSERT ( helper_token_match ( tokens, "ab\naabc") == TRUE );
+        tokenize_free ( tokens );
+        tokens = tokenize ( "**", FALSE );
+        TASSERT ( helper_token_match ( tokens, "") == TRUE );
+        tokenize_free ( tokens );
+        tokens = tokenize ( "k\u00e9?", FALSE );
+        TASSERT ( helper_token_match ( tokens, "\u212A\u00c9x") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "K\u00c9") == FALSE );
+        tokenize_free ( tokens );
+    }
+    {
+        // The native glob matcher matches the same as the regex globs used to be translated to.
+        const char *globs[] = { "n*t", "*oo?", "?", "a?*b", "*a*a*b", "\u00e9*\u212a", "a.b*", "(a)?[", "s?s", "**x" };
+        const char *rows[]  = { "", "noot", "NOOT mies", "aap", "a\nb", "aab", "ab\nab", "a.bc", "(a)x[", "\u00c9\u00e9 k",
+                                "a b", "\u017fts", "SxS", "xx", "a\u00a0b", "aaaaaaaaaab" };
+        config.matching_method = MM_GLOB;
+        for ( int cs = 0; cs < 2; cs++ ) {
+            for ( size_t i = 0; i < G_N_ELEMENTS ( globs ); i++ ) {
+                rofi_int_matcher **tokens = tokenize ( globs[i], cs );
+                GString          *str     = g_string_new ( NULL );
+                for ( const char *p = globs[i]; *p != '\0'; ) {
+                    size_t len = strcspn ( p, "*?" );
+                    if ( len > 0 ) {
+                        char *e = g_regex_escape_string ( p, len );
+                        g_string_append ( str, e );
+                        g_free ( e );
+                        p += len;
+                    }
+                    else {
+                        g_string_append ( str, *p == '*' ? ".*" : "\\S" );
+                        p++;
+                    }
+                }
+                GRegex   *regex = g_regex_new ( str->str, cs ? 0 : G_REGEX_CASELESS, 0, NULL );
+                gboolean same   = TRUE;
+                for ( size_t j = 0; j < G_N_ELEMENTS ( rows ); j++ ) {
+                    same &= helper_token_match ( tokens, rows[j] ) == g_regex_match ( regex, rows[j], 0, NULL );
+                }
+                TASSERT ( same );
+                g_regex_unref ( regex );
+                g_string_free ( str, TRUE );
+                tokenize_free ( tokens );
+            }
+        }
+    }
+    {
+        // Matching a range gives the same as matching each row.
+        char *rows[] = { "aap noot", "noot mies", "aap", "", "mies aap noot", "NOOT", "noo t", "aap noot mies",
+                         "noot", "x", "aap", "noot aap", "n", "oo", "noot noot", "aap", "mies", "aapnoot", "q",
+                         "noot", "aap", "aap noot", "m", "mies", "noot", "aap", "aap", "noot", "r", "aap", "s",
+                         "aap noot", "noot aap", "t" };
+        config.matching_method = MM_NORMAL;
+        const char *inputs[] = { "aap noot", "noot", "zz", "a" };
+        for ( size_t t = 0; t < G_N_ELEMENTS ( inputs ); t++ ) {
+            rofi_int_matcher **tokens = tokenize ( inputs[t], FALSE );
+            guint32          matches[2] = { 0, 0 };
+            gboolean         same       = TRUE;
+            helper_token_match_range ( tokens, rows, 1, G_N_ELEMENTS ( rows ), matches );
+            for ( unsigned int i = 1; i < G_N_ELEMENTS ( rows ); i++ ) {
+                same &= helper_match_bitmap_get ( matches, i - 1 ) == helper_token_match ( tokens, rows[i] );
+            }
+            same &= !helper_match_bitmap_get ( matches, G_N_ELEMENTS ( rows ) - 1 );
+            TASSERT ( same );
+            tokenize_free ( tokens );
+        }
     }
     {
         config.matching_method = MM_FUZZY;
-        GRegex **tokens = tokenize ( "noot", FALSE );
+        rofi_int_matcher **tokens = tokenize ( "noot", FALSE );
 
         TASSERT ( helper_token_match ( tokens, "aap noot mies") == TRUE );
         TASSERT ( helper_token_match ( tokens, "aap mies") == FALSE );
@@ -210,6 +319,12 @@ int main ( int argc, char ** argv )
         TASSERT ( helper_token_match ( tokens, "nootap nmiest") == TRUE );
         tokenize_free ( tokens );
 
+        // A match stays on one line, like '*' in a glob.
+        tokens = tokenize ( "ab", FALSE );
+        TASSERT ( helper_token_match ( tokens, "a\nb") == FALSE );
+        TASSERT ( helper_token_match ( tokens, "a\nab") == TRUE );
+        tokenize_free ( tokens );
+
         tokens = tokenize ( "o n t", FALSE );
         TASSERT ( helper_token_match ( tokens, "aap noot mies") == TRUE );
         TASSERT ( helper_token_match ( tokens, "aap mies") == FALSE );
@@ -218,10 +333,30 @@ int main ( int argc, char ** argv )
         TASSERT ( helper_token_match ( tokens, "noap miesot") == TRUE);
         TASSERT ( helper_token_match ( tokens, "ot nap mies") == TRUE);
         tokenize_free ( tokens );
+
+        // Case folding beyond ASCII.
+        tokens = tokenize ( "één", FALSE );
+        TASSERT ( helper_token_match ( tokens, "Één keer") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "eÉn keer Én") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "een keer") == FALSE );
+        tokenize_free ( tokens );
+        tokens = tokenize ( "kS", FALSE );
+        TASSERT ( helper_token_match ( tokens, "\u212Aelvin \u017F") == TRUE );
+        tokenize_free ( tokens );
+        tokens = tokenize ( "één", TRUE );
+        TASSERT ( helper_token_match ( tokens, "Één keer") == FALSE );
+        TASSERT ( helper_token_match ( tokens, "één keer") == TRUE );
+        tokenize_free ( tokens );
+
+        // Long entry without a match.
+        tokens = tokenize ( "aaaaaaaaaaab", FALSE );
+        TASSERT ( helper_token_match ( tokens, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa" ) == FALSE );
+        TASSERT ( helper_token_match ( tokens, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab" ) == TRUE );
+        tokenize_free ( tokens );
     }
     {
         config.matching_method = MM_REGEX;
-        GRegex **tokens = tokenize ( "noot", FALSE );
+        rofi_int_matcher **tokens = tokenize ( "noot", FALSE );
 
         TASSERT ( helper_token_match ( tokens, "aap noot mies") == TRUE );
         TASSERT ( helper_token_match ( tokens, "aap mies") == FALSE );
@@ -277,4 +412,46 @@ int main ( int argc, char ** argv )
         TASSERT ( helper_token_match ( tokens, "ot nap mies") == FALSE );
         tokenize_free ( tokens );
     }
+    {
+        // Compiled tokens are reused, but not between matching methods.
+        config.matching_method = MM_NORMAL;
+        rofi_int_matcher **tokens = tokenize ( "n.ot n.ot", FALSE );
+        TASSERT ( helper_token_match ( tokens, "aap noot mies" ) == FALSE );
+        TASSERT ( helper_token_match ( tokens, "aap n.ot mies" ) == TRUE );
+        tokenize_free ( tokens );
+        config.matching_method = MM_REGEX;
+        tokens = tokenize ( "n.ot", FALSE );
+        rofi_int_matcher **again = tokenize ( "n.ot", FALSE );
+        TASSERT ( helper_token_match ( tokens, "aap noot mies" ) == TRUE );
+        tokenize_free ( tokens );
+        TASSERT ( helper_token_match ( again, "aap noot mies" ) == TRUE );
+        tokenize_free ( again );
+        tokenize_cache_clear ();
+        tokens = tokenize ( "n.ot", TRUE );
+        TASSERT ( helper_token_match ( tokens, "aap NOOT mies" ) == FALSE );
+        tokenize_free ( tokens );
+    }
+    {
+        // Highlighted parts, found natively for plain tokens.
+        config.matching_method = MM_NORMAL;
+        rofi_int_matcher **tokens = tokenize ( "noot", FALSE );
+        GArray           *spans   = helper_token_match_get_spans ( tokens, "Noot aap noot" );
+        TASSERT ( spans->len == 2 );
+        TASSERT ( g_array_index ( spans, rofi_match_span, 0 ).start == 0 && g_array_index ( spans, rofi_match_span, 0 ).end == 4 );
+        TASSERT ( g_array_index ( spans, rofi_match_span, 1 ).start == 9 && g_array_index ( spans, rofi_match_span, 1 ).end == 13 );
+        g_array_free ( spans, TRUE );
+        tokenize_free ( tokens );
+        tokens = tokenize ( "n.ot", FALSE );
+        spans  = helper_token_match_get_spans ( tokens, "aap noot" );
+        TASSERT ( spans->len == 0 );
+        g_array_free ( spans, TRUE );
+        tokenize_free ( tokens );
+        config.matching_method = MM_REGEX;
+        tokens = tokenize ( "n.ot", FALSE );
+        spans  = helper_token_match_get_spans ( tokens, "aap noot" );
+        TASSERT ( spans->len == 1 );
+        TASSERT ( g_array_index ( spans, rofi_match_span, 0 ).start == 4 && g_array_index ( spans, rofi_match_span, 0 ).end == 8 );
+        g_array_free ( spans, TRUE );
+        tokenize_free ( tokens );
+    }
 }
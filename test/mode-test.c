@@ -141,7 +141,7 @@ END_TEST
 
 START_TEST(test_mode_match_entry)
 {
-    GRegex **t = tokenize( "primary-paste", FALSE );
+    rofi_int_matcher **t = tokenize( "primary-paste", FALSE );
     ck_assert_ptr_nonnull ( t );
 
     ck_assert_int_eq ( mode_token_match ( &help_keys_mode, t, 0), TRUE );
@@ -158,6 +158,37 @@ START_TEST(test_mode_match_entry)
 }
 END_TEST
 
+START_TEST(test_mode_match_range)
+{
+    // help-keys only matches one entry at a time, the range falls back to that.
+    unsigned int rows = mode_get_num_entries ( &help_keys_mode);
+    rofi_int_matcher **t = tokenize( "-paste", FALSE );
+    guint32 *matches = g_malloc0_n ( ( rows + 31 ) / 32, sizeof ( guint32 ) );
+    mode_token_match_range ( &help_keys_mode, t, 1, rows, matches );
+    for ( unsigned int i = 1; i < rows; i++ ){
+        ck_assert_int_eq ( helper_match_bitmap_get ( matches, i - 1 ), mode_token_match ( &help_keys_mode, t, i ) );
+    }
+    g_free ( matches );
+    tokenize_free ( t );
+}
+END_TEST
+
+START_TEST(test_mode_match_string)
+{
+    unsigned int rows = mode_get_num_entries ( &help_keys_mode);
+    for ( unsigned int i =0; i < rows; i++  ){
+        glong length = -1;
+        const char *str = mode_get_match_string ( &help_keys_mode, i, 0, &length );
+        char *comp = mode_get_completion ( &help_keys_mode, i );
+        ck_assert_ptr_nonnull ( str );
+        ck_assert_str_eq ( str, comp );
+        ck_assert_int_eq ( length, g_utf8_strlen ( comp, -1 ) );
+        g_free ( comp );
+        ck_assert_ptr_null ( mode_get_match_string ( &help_keys_mode, i, 1, &length ) );
+    }
+}
+END_TEST
+
 Suite * mode_suite (void)
 {
     Suite *s;
@@ -173,6 +204,8 @@ Suite * mode_suite (void)
     tcase_add_test(tc_core, test_mode_result );
     tcase_add_test(tc_core, test_mode_destroy);
     tcase_add_test(tc_core, test_mode_match_entry );
+    tcase_add_test(tc_core, test_mode_match_range );
+    tcase_add_test(tc_core, test_mode_match_string );
     suite_add_tcase(s, tc_core);
 
     return s;
@@ -0,0 +1,164 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/**
+ * Filter a generated list with 1 to N workers and print the speedup.
+ *
+ * Usage: parallel_benchmark [lines] [max workers] [pattern]
+ */
+
+#include <locale.h>
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <helper.h>
+#include <xcb/xcb_ewmh.h>
+#include "xcb-internal.h"
+#include "rofi.h"
+#include "settings.h"
+#include "parallel.h"
+
+struct xcb_stuff *xcb;
+
+void rofi_add_error_message ( G_GNUC_UNUSED GString *msg )
+{
+}
+int rofi_view_error_dialog ( const char *msg, G_GNUC_UNUSED int markup )
+{
+    fputs ( msg, stderr );
+    return TRUE;
+}
+int show_error_message ( const char *msg, int markup )
+{
+    rofi_view_error_dialog ( msg, markup );
+    return 0;
+}
+xcb_screen_t          *xcb_screen;
+xcb_ewmh_connection_t xcb_ewmh;
+int                   xcb_screen_nbr;
+
+typedef struct
+{
+    char             **lines;
+    rofi_int_matcher **tokens;
+    unsigned int     *line_map;
+    unsigned int     *chunk_count;
+} BenchmarkData;
+
+static void benchmark_filter ( G_GNUC_UNUSED unsigned int worker, unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data )
+{
+    BenchmarkData *d     = (BenchmarkData *) user_data;
+    unsigned int  count = 0;
+    for ( unsigned int i = start; i < stop; i++ ) {
+        if ( helper_token_match ( d->tokens, d->lines[i] ) ) {
+            d->line_map[start + count] = i;
+            count++;
+        }
+    }
+    d->chunk_count[chunk] = count;
+}
+
+/**
+ * Generate lines of mixed length. Every 64th line is very long, so chunks differ in cost
+ * like they do with a real list.
+ */
+static char ** benchmark_generate ( unsigned int n )
+{
+    static const char words[][8] = { "rofi", "window", "run", "ssh", "drun", "term", "edit", "mail", "web", "files" };
+    GRand             *rand      = g_rand_new_with_seed ( 42 );
+    char              **lines    = g_malloc0_n ( n + 1, sizeof ( char* ) );
+    for ( unsigned int i = 0; i < n; i++ ) {
+        unsigned int nwords = ( i % 64 ) == 0 ? 400 : (unsigned int) g_rand_int_range ( rand, 1, 8 );
+        GString      *str   = g_string_new ( NULL );
+        for ( unsigned int w = 0; w < nwords; w++ ) {
+            g_string_append_printf ( str, "%s%s-%d", w ? " " : "", words[g_rand_int_range ( rand, 0, 10 )], g_rand_int_range ( rand, 0, 1000 ) );
+        }
+        lines[i] = g_string_free ( str, FALSE );
+    }
+    g_rand_free ( rand );
+    return lines;
+}
+
+int main ( int argc, char **argv )
+{
+    if ( setlocale ( LC_ALL, "" ) == NULL ) {
+        fprintf ( stderr, "Failed to set locale.\n" );
+        return EXIT_FAILURE;
+    }
+    unsigned int n           = argc > 1 ? (unsigned int) strtoul ( argv[1], NULL, 10 ) : 1000000;
+    long         procs       = sysconf ( _SC_NPROCESSORS_ONLN );
+    unsigned int max_workers = argc > 2 ? (unsigned int) strtoul ( argv[2], NULL, 10 ) : (unsigned int) MAX ( procs, 1 );
+    const char   *pattern    = argc > 3 ? argv[3] : "term 42";
+    const int    rounds      = 5;
+
+    char         **lines = benchmark_generate ( n );
+    BenchmarkData d      = {
+        .lines    = lines,
+        .tokens   = tokenize ( pattern, FALSE ),
+        .line_map = g_malloc0_n ( n + 1, sizeof ( unsigned int ) ),
+    };
+
+    printf ( "%u lines, pattern '%s', best of %d rounds.\n", n, pattern, rounds );
+    printf ( "%8s %12s %10s %10s\n", "workers", "time (ms)", "speedup", "matches" );
+    double base = 0.0;
+    for ( unsigned int workers = 1; workers <= max_workers; workers++ ) {
+        rofi_parallel_init ( workers, NULL );
+        RofiParallelRange range;
+        rofi_parallel_range_init ( &range, n, 500 );
+        d.chunk_count = g_malloc0_n ( range.num_chunks + 1, sizeof ( unsigned int ) );
+
+        double       best    = G_MAXDOUBLE;
+        unsigned int matches = 0;
+        for ( int r = 0; r < rounds; r++ ) {
+            GTimer *timer = g_timer_new ();
+            rofi_parallel_for ( &range, benchmark_filter, &d );
+            matches = 0;
+            for ( unsigned int i = 0; i < range.num_chunks; i++ ) {
+                unsigned int start = i * range.chunk_size;
+                if ( matches != start ) {
+                    memmove ( &( d.line_map[matches] ), &( d.line_map[start] ), sizeof ( unsigned int ) * d.chunk_count[i] );
+                }
+                matches += d.chunk_count[i];
+            }
+            best = MIN ( best, g_timer_elapsed ( timer, NULL ) );
+            g_timer_destroy ( timer );
+        }
+        if ( workers == 1 ) {
+            base = best;
+        }
+        printf ( "%8u %12.2f %10.2f %10u\n", workers, best * 1000.0, base / best, matches );
+        g_free ( d.chunk_count );
+        rofi_parallel_cleanup ();
+    }
+
+    tokenize_free ( d.tokens );
+    g_free ( d.line_map );
+    g_strfreev ( lines );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <assert.h>
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "parallel.h"
+
+static int test = 0;
+
+#define TASSERT( a )        {                            \
+        assert ( a );                                    \
+        printf ( "Test %i passed (%s)\n", ++test, # a ); \
+}
+
+typedef struct
+{
+    gint         *visits;
+    unsigned int *chunk_length;
+    gint         bad_chunks;
+} ParallelTestData;
+
+static void parallel_test_chunk ( G_GNUC_UNUSED unsigned int worker, unsigned int chunk, unsigned int start, unsigned int stop, gpointer user_data )
+{
+    ParallelTestData *d = (ParallelTestData *) user_data;
+    d->chunk_length[chunk] = stop - start;
+    if ( start >= stop ) {
+        g_atomic_int_inc ( &( d->bad_chunks ) );
+    }
+    for ( unsigned int i = start; i < stop; i++ ) {
+        g_atomic_int_inc ( &( d->visits[i] ) );
+        // Make some chunks a lot slower, so other workers have to steal them.
+        if ( ( i % 1024 ) == 0 ) {
+            g_usleep ( 200 );
+        }
+    }
+}
+
+/**
+ * Run a loop over n elements and check each element is visited exactly once
+ * and the chunks cover the range in order.
+ */
+static gboolean parallel_test_cover ( unsigned int n, unsigned int min_chunk_size )
+{
+    RofiParallelRange range;
+    rofi_parallel_range_init ( &range, n, min_chunk_size );
+    ParallelTestData  d = {
+        .visits       = g_malloc0_n ( n + 1, sizeof ( gint ) ),
+        .chunk_length = g_malloc0_n ( range.num_chunks + 1, sizeof ( unsigned int ) ),
+        .bad_chunks   = 0,
+    };
+    rofi_parallel_for ( &range, parallel_test_chunk, &d );
+
+    gboolean     retv  = d.bad_chunks == 0;
+    unsigned int total = 0;
+    for ( unsigned int i = 0; i < range.num_chunks; i++ ) {
+        // Only the last chunk can be shorter.
+        if ( i + 1 < range.num_chunks && d.chunk_length[i] != range.chunk_size ) {
+            retv = FALSE;
+        }
+        total += d.chunk_length[i];
+    }
+    for ( unsigned int i = 0; i < n; i++ ) {
+        if ( d.visits[i] != 1 ) {
+            retv = FALSE;
+        }
+    }
+    g_free ( d.visits );
+    g_free ( d.chunk_length );
+    return retv && total == n;
+}
+
+int main ( G_GNUC_UNUSED int argc, G_GNUC_UNUSED char **argv )
+{
+    RofiParallelRange range;
+
+    // Single threaded, everything in one chunk.
+    TASSERT ( rofi_parallel_init ( 1, NULL ) );
+    TASSERT ( rofi_parallel_num_workers () == 1 );
+    rofi_parallel_range_init ( &range, 100000, 500 );
+    TASSERT ( range.num_chunks == 1 );
+    TASSERT ( range.chunk_size == 100000 );
+    rofi_parallel_range_init ( &range, 0, 500 );
+    TASSERT ( range.num_chunks == 0 );
+    TASSERT ( parallel_test_cover ( 0, 500 ) );
+    TASSERT ( parallel_test_cover ( 12345, 500 ) );
+    rofi_parallel_cleanup ();
+
+    TASSERT ( rofi_parallel_init ( 4, NULL ) );
+    TASSERT ( rofi_parallel_num_workers () == 4 );
+    // Short ranges are not split below the minimum size.
+    rofi_parallel_range_init ( &range, 499, 500 );
+    TASSERT ( range.num_chunks == 1 );
+    rofi_parallel_range_init ( &range, 1001, 500 );
+    TASSERT ( range.num_chunks == 3 );
+    TASSERT ( range.chunk_size == 500 );
+    // Long ranges get a few chunks per worker.
+    rofi_parallel_range_init ( &range, 1000000, 500 );
+    TASSERT ( range.num_chunks == 32 );
+    TASSERT ( range.chunk_size == 31250 );
+    rofi_parallel_range_init ( &range, 1000001, 500 );
+    TASSERT ( range.num_chunks == 32 );
+    TASSERT ( range.chunk_size * range.num_chunks >= 1000001 );
+
+    TASSERT ( parallel_test_cover ( 0, 500 ) );
+    TASSERT ( parallel_test_cover ( 1, 1 ) );
+    TASSERT ( parallel_test_cover ( 7, 1 ) );
+    TASSERT ( parallel_test_cover ( 501, 500 ) );
+    TASSERT ( parallel_test_cover ( 100003, 500 ) );
+    TASSERT ( parallel_test_cover ( 1000000, 500 ) );
+    // Again, reusing the now running threads.
+    for ( unsigned int i = 0; i < 10; i++ ) {
+        TASSERT ( parallel_test_cover ( 65536 + i, 1 ) );
+    }
+    rofi_parallel_cleanup ();
+    TASSERT ( rofi_parallel_num_workers () == 1 );
+    return EXIT_SUCCESS;
+}
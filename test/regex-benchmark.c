@@ -0,0 +1,158 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+/**
+ * Match generated log lines against regex and glob patterns, with rofi's matchers (PCRE2 for regex
+ * when configured with --enable-pcre2, the native glob matcher for globs) and with GRegex, and print the speedup.
+ *
+ * Usage: regex_benchmark [lines]
+ */
+
+#include <locale.h>
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <helper.h>
+#include <xcb/xcb_ewmh.h>
+#include "xcb-internal.h"
+#include "rofi.h"
+#include "settings.h"
+
+struct xcb_stuff *xcb;
+
+void rofi_add_error_message ( G_GNUC_UNUSED GString *msg )
+{
+}
+int rofi_view_error_dialog ( const char *msg, G_GNUC_UNUSED int markup )
+{
+    fputs ( msg, stderr );
+    return TRUE;
+}
+int show_error_message ( const char *msg, int markup )
+{
+    rofi_view_error_dialog ( msg, markup );
+    return 0;
+}
+xcb_screen_t          *xcb_screen;
+xcb_ewmh_connection_t xcb_ewmh;
+int                   xcb_screen_nbr;
+
+/**
+ * A pattern as typed, and the same pattern as regex for GRegex.
+ */
+typedef struct
+{
+    MatchingMethod method;
+    const char     *pattern;
+    const char     *regex;
+} BenchmarkPattern;
+
+static const BenchmarkPattern patterns[] = {
+    { MM_REGEX, "error",                         "error"                         },
+    { MM_REGEX, "^2017-0[1-6]",                  "^2017-0[1-6]"                  },
+    { MM_REGEX, "(warn|error).*disk[0-9]+",      "(warn|error).*disk[0-9]+"      },
+    { MM_REGEX, "[0-9]{1,3}\\.[0-9]{1,3}\\.9\\.", "[0-9]{1,3}\\.[0-9]{1,3}\\.9\\." },
+    { MM_GLOB,  "*kernel*disk?1*",               ".*kernel.*disk\\S1.*"          },
+};
+
+/**
+ * Generate lines that look like a system log.
+ */
+static char ** benchmark_generate ( unsigned int n )
+{
+    static const char levels[][8]   = { "info", "debug", "warn", "error" };
+    static const char sources[][10] = { "kernel", "sshd", "cron", "systemd", "NetworkM" };
+    GRand             *rand         = g_rand_new_with_seed ( 42 );
+    char              **lines       = g_malloc0_n ( n + 1, sizeof ( char* ) );
+    for ( unsigned int i = 0; i < n; i++ ) {
+        lines[i] = g_strdup_printf ( "2017-%02d-%02d %02d:%02d:%02d %s[%d]: %s: disk%d at 10.%d.%d.%d took %d ms",
+                                     g_rand_int_range ( rand, 1, 13 ), g_rand_int_range ( rand, 1, 29 ),
+                                     g_rand_int_range ( rand, 0, 24 ), g_rand_int_range ( rand, 0, 60 ), g_rand_int_range ( rand, 0, 60 ),
+                                     sources[g_rand_int_range ( rand, 0, 5 )], g_rand_int_range ( rand, 1, 32768 ),
+                                     levels[g_rand_int_range ( rand, 0, 4 )], g_rand_int_range ( rand, 0, 16 ),
+                                     g_rand_int_range ( rand, 0, 256 ), g_rand_int_range ( rand, 0, 256 ), g_rand_int_range ( rand, 0, 256 ),
+                                     g_rand_int_range ( rand, 0, 5000 ) );
+    }
+    g_rand_free ( rand );
+    return lines;
+}
+
+int main ( int argc, char **argv )
+{
+    if ( setlocale ( LC_ALL, "" ) == NULL ) {
+        fprintf ( stderr, "Failed to set locale.\n" );
+        return EXIT_FAILURE;
+    }
+    unsigned int n      = argc > 1 ? (unsigned int) strtoul ( argv[1], NULL, 10 ) : 1000000;
+    const int    rounds = 3;
+    char         **lines = benchmark_generate ( n );
+    int          retv    = EXIT_SUCCESS;
+
+#ifdef ENABLE_PCRE2
+    const char *backend = "PCRE2";
+#else
+    const char *backend = "GRegex";
+#endif
+    printf ( "%u lines, best of %d rounds, matcher built with %s.\n", n, rounds, backend );
+    printf ( "%-36s %12s %12s %10s %10s\n", "pattern", "GRegex (ms)", "rofi (ms)", "speedup", "matches" );
+    for ( unsigned int p = 0; p < G_N_ELEMENTS ( patterns ); p++ ) {
+        config.matching_method = patterns[p].method;
+        rofi_int_matcher **tokens = tokenize ( patterns[p].pattern, FALSE );
+        GRegex           *regex   = g_regex_new ( patterns[p].regex, G_REGEX_OPTIMIZE | G_REGEX_CASELESS, 0, NULL );
+        double           best_gregex = G_MAXDOUBLE, best_rofi = G_MAXDOUBLE;
+        unsigned int     matches_gregex = 0, matches_rofi = 0;
+        for ( int r = 0; r < rounds; r++ ) {
+            GTimer *timer = g_timer_new ();
+            matches_gregex = 0;
+            for ( unsigned int i = 0; i < n; i++ ) {
+                matches_gregex += g_regex_match ( regex, lines[i], 0, NULL );
+            }
+            best_gregex = MIN ( best_gregex, g_timer_elapsed ( timer, NULL ) );
+
+            g_timer_start ( timer );
+            matches_rofi = 0;
+            for ( unsigned int i = 0; i < n; i++ ) {
+                matches_rofi += helper_token_match ( tokens, lines[i] );
+            }
+            best_rofi = MIN ( best_rofi, g_timer_elapsed ( timer, NULL ) );
+            g_timer_destroy ( timer );
+        }
+        printf ( "%-36s %12.2f %12.2f %10.2f %10u\n", patterns[p].pattern, best_gregex * 1000.0, best_rofi * 1000.0,
+                 best_gregex / best_rofi, matches_rofi );
+        if ( matches_gregex != matches_rofi ) {
+            fprintf ( stderr, "Mismatch on '%s': GRegex %u, rofi %u.\n", patterns[p].pattern, matches_gregex, matches_rofi );
+            retv = EXIT_FAILURE;
+        }
+        g_regex_unref ( regex );
+        tokenize_free ( tokens );
+    }
+    tokenize_cache_clear ();
+    g_strfreev ( lines );
+    return retv;
+}
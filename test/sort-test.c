@@ -0,0 +1,303 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <assert.h>
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "parallel.h"
+#include "sort.h"
+
+static int test = 0;
+
+#define TASSERT( a )        {                            \
+        assert ( a );                                    \
+        printf ( "Test %i passed (%s)\n", ++test, # a ); \
+}
+
+static gboolean sort_test_before ( const int *distance, unsigned int a, unsigned int b )
+{
+    return distance[a] < distance[b] || ( distance[a] == distance[b] && a < b );
+}
+
+/**
+ * Partially sort a shuffled list and check the first k rows are in order
+ * and come before all others, and that no row got lost.
+ */
+static gboolean sort_test_partial ( const int *distance, unsigned int n, unsigned int k )
+{
+    unsigned int *rows = g_malloc_n ( n + 1, sizeof ( unsigned int ) );
+    unsigned int *seen = g_malloc0_n ( n + 1, sizeof ( unsigned int ) );
+    gboolean     retv  = TRUE;
+    for ( unsigned int i = 0; i < n; i++ ) {
+        rows[i] = i;
+    }
+    for ( unsigned int i = n; i > 1; i-- ) {
+        unsigned int j   = g_random_int_range ( 0, i );
+        unsigned int tmp = rows[i - 1];
+        rows[i - 1] = rows[j];
+        rows[j]     = tmp;
+    }
+    rofi_sort_partial ( rows, n, k, distance );
+    k = MIN ( k, n );
+    for ( unsigned int i = 0; i < n; i++ ) {
+        seen[rows[i]]++;
+        if ( i > 0 && i < k && !sort_test_before ( distance, rows[i - 1], rows[i] ) ) {
+            retv = FALSE;
+        }
+        if ( k > 0 && i >= k && !sort_test_before ( distance, rows[k - 1], rows[i] ) ) {
+            retv = FALSE;
+        }
+    }
+    for ( unsigned int i = 0; i < n; i++ ) {
+        if ( seen[i] != 1 ) {
+            retv = FALSE;
+        }
+    }
+    // Sorting the rest in steps gives the full order.
+    unsigned int sorted = k;
+    while ( sorted < n ) {
+        unsigned int step = MIN ( MAX ( 7, n / 16 ), n - sorted );
+        rofi_sort_partial ( &( rows[sorted] ), n - sorted, step, distance );
+        sorted += step;
+    }
+    for ( unsigned int i = 1; i < n; i++ ) {
+        if ( !sort_test_before ( distance, rows[i - 1], rows[i] ) ) {
+            retv = FALSE;
+        }
+    }
+    g_free ( seen );
+    g_free ( rows );
+    return retv;
+}
+
+/**
+ * Sort a list of rows in reversed order and check the result against the comparison.
+ */
+static gboolean sort_test_rows ( const int *distance, unsigned int n )
+{
+    unsigned int *rows = g_malloc_n ( n + 1, sizeof ( unsigned int ) );
+    gboolean     retv  = TRUE;
+    for ( unsigned int i = 0; i < n; i++ ) {
+        rows[i] = n - 1 - i;
+    }
+    rofi_sort_rows ( rows, n, distance );
+    for ( unsigned int i = 1; i < n; i++ ) {
+        if ( !sort_test_before ( distance, rows[i - 1], rows[i] ) ) {
+            retv = FALSE;
+        }
+    }
+    g_free ( rows );
+    return retv;
+}
+
+/**
+ * Cut the rows in num_runs runs of random length, sort each and merge them.
+ */
+static gboolean sort_test_merge ( const int *distance, unsigned int n, unsigned int num_runs )
+{
+    unsigned int *rows       = g_malloc_n ( n + 1, sizeof ( unsigned int ) );
+    unsigned int *merged     = g_malloc_n ( n + 1, sizeof ( unsigned int ) );
+    unsigned int *seen       = g_malloc0_n ( n + 1, sizeof ( unsigned int ) );
+    unsigned int *run_start  = g_malloc0_n ( num_runs, sizeof ( unsigned int ) );
+    unsigned int *run_length = g_malloc0_n ( num_runs, sizeof ( unsigned int ) );
+    gboolean     retv        = TRUE;
+    for ( unsigned int i = 0; i < n; i++ ) {
+        rows[i] = n - 1 - i;
+    }
+    unsigned int start = 0;
+    for ( unsigned int r = 0; r < num_runs; r++ ) {
+        run_start[r]  = start;
+        run_length[r] = ( r + 1 == num_runs ) ? n - start : (unsigned int) g_random_int_range ( 0, ( n - start ) / 2 + 1 );
+        rofi_sort_rows_serial ( &( rows[start] ), run_length[r], distance );
+        start += run_length[r];
+    }
+    rofi_sort_merge ( merged, rows, run_start, run_length, num_runs, distance );
+    for ( unsigned int i = 0; i < n; i++ ) {
+        seen[merged[i]]++;
+        if ( i > 0 && !sort_test_before ( distance, merged[i - 1], merged[i] ) ) {
+            retv = FALSE;
+        }
+    }
+    for ( unsigned int i = 0; i < n; i++ ) {
+        if ( seen[i] != 1 ) {
+            retv = FALSE;
+        }
+    }
+    g_free ( run_length );
+    g_free ( run_start );
+    g_free ( seen );
+    g_free ( merged );
+    g_free ( rows );
+    return retv;
+}
+
+/**
+ * Partially sort n shuffled rows and m appended rows apart, as the view does when rows are added,
+ * merge them and check the order of the result and that sorting the rest gives the full order.
+ */
+static gboolean sort_test_append ( const int *distance, unsigned int n, unsigned int sorted, unsigned int m, unsigned int m_sorted )
+{
+    unsigned int *rows = g_malloc_n ( n + m + 1, sizeof ( unsigned int ) );
+    unsigned int *seen = g_malloc0_n ( n + m + 1, sizeof ( unsigned int ) );
+    gboolean     retv  = TRUE;
+    for ( unsigned int i = 0; i < n + m; i++ ) {
+        rows[i] = n + m - 1 - i;
+    }
+    sorted   = MIN ( sorted, n );
+    m_sorted = MIN ( m_sorted, m );
+    rofi_sort_partial ( rows, n, sorted, distance );
+    rofi_sort_partial ( &( rows[n] ), m, m_sorted, distance );
+    unsigned int in_order = rofi_sort_append ( rows, n, sorted, m, m_sorted, distance );
+    if ( sorted == n && m_sorted == m && in_order != n + m ) {
+        retv = FALSE;
+    }
+    for ( unsigned int i = 0; i < n + m; i++ ) {
+        seen[rows[i]]++;
+        if ( i > 0 && i < in_order && !sort_test_before ( distance, rows[i - 1], rows[i] ) ) {
+            retv = FALSE;
+        }
+        if ( in_order > 0 && i >= in_order && !sort_test_before ( distance, rows[in_order - 1], rows[i] ) ) {
+            retv = FALSE;
+        }
+    }
+    for ( unsigned int i = 0; i < n + m; i++ ) {
+        if ( seen[i] != 1 ) {
+            retv = FALSE;
+        }
+    }
+    while ( in_order < n + m ) {
+        unsigned int step = MIN ( 7, n + m - in_order );
+        rofi_sort_partial ( &( rows[in_order] ), n + m - in_order, step, distance );
+        in_order += step;
+    }
+    for ( unsigned int i = 1; i < n + m; i++ ) {
+        if ( !sort_test_before ( distance, rows[i - 1], rows[i] ) ) {
+            retv = FALSE;
+        }
+    }
+    g_free ( seen );
+    g_free ( rows );
+    return retv;
+}
+
+int main ( G_GNUC_UNUSED int argc, G_GNUC_UNUSED char **argv )
+{
+    const unsigned int n         = 10000;
+    int                *distance = g_malloc_n ( n, sizeof ( int ) );
+    g_random_set_seed ( 42 );
+
+    // Equal distance: order on row index.
+    int                equal[] = { 3, 1, 3, 1, 1 };
+    unsigned int       rows[]  = { 4, 3, 2, 1, 0 };
+    rofi_sort_partial ( rows, 5, 2, equal );
+    TASSERT ( rows[0] == 1 && rows[1] == 3 );
+    rofi_sort_partial ( &( rows[2] ), 3, 3, equal );
+    TASSERT ( rows[2] == 4 && rows[3] == 0 && rows[4] == 2 );
+    unsigned int       serial[] = { 4, 3, 2, 1, 0 };
+    rofi_sort_partial_serial ( serial, 5, 2, equal );
+    TASSERT ( serial[0] == 1 && serial[1] == 3 );
+
+    TASSERT ( sort_test_partial ( equal, 0, 10 ) );
+    TASSERT ( sort_test_partial ( equal, 5, 0 ) );
+    TASSERT ( sort_test_partial ( equal, 5, 5 ) );
+    TASSERT ( sort_test_partial ( equal, 5, 50 ) );
+
+    // Few distinct distances, many ties.
+    for ( unsigned int i = 0; i < n; i++ ) {
+        distance[i] = g_random_int_range ( 0, 4 );
+    }
+    TASSERT ( sort_test_partial ( distance, n, 1 ) );
+    TASSERT ( sort_test_partial ( distance, n, 100 ) );
+    TASSERT ( sort_test_partial ( distance, n, n - 1 ) );
+
+    // Many distinct distances.
+    for ( unsigned int i = 0; i < n; i++ ) {
+        distance[i] = g_random_int_range ( -1000000, 1000000 );
+    }
+    TASSERT ( sort_test_partial ( distance, n, 1 ) );
+    TASSERT ( sort_test_partial ( distance, n, 100 ) );
+    TASSERT ( sort_test_partial ( distance, n, n / 2 ) );
+
+    // Already in order and reversed.
+    for ( unsigned int i = 0; i < n; i++ ) {
+        distance[i] = i;
+    }
+    TASSERT ( sort_test_partial ( distance, n, 100 ) );
+    for ( unsigned int i = 0; i < n; i++ ) {
+        distance[i] = n - i;
+    }
+    TASSERT ( sort_test_partial ( distance, n, 100 ) );
+
+    // Appending rows to a partially sorted list.
+    for ( unsigned int i = 0; i < n; i++ ) {
+        distance[i] = g_random_int_range ( 0, 50 );
+    }
+    TASSERT ( sort_test_append ( distance, 0, 0, 100, 100 ) );
+    TASSERT ( sort_test_append ( distance, 100, 100, 0, 0 ) );
+    TASSERT ( sort_test_append ( distance, 300, 300, 200, 200 ) );
+    TASSERT ( sort_test_append ( distance, 3000, 256, 2000, 256 ) );
+    TASSERT ( sort_test_append ( distance, 3000, 256, 20, 20 ) );
+    TASSERT ( sort_test_append ( distance, 20, 20, 3000, 256 ) );
+    TASSERT ( sort_test_append ( distance, 100, 0, 100, 0 ) );
+    TASSERT ( sort_test_append ( distance, 5000, 10, 4000, 1000 ) );
+
+    // Long lists are radix sorted, check with one and with more workers.
+    const unsigned int large       = 200000;
+    int                *large_dist = g_malloc_n ( large, sizeof ( int ) );
+    unsigned int       workers[]   = { 1, 4 };
+    for ( unsigned int w = 0; w < G_N_ELEMENTS ( workers ); w++ ) {
+        TASSERT ( rofi_parallel_init ( workers[w], NULL ) );
+        for ( unsigned int i = 0; i < large; i++ ) {
+            large_dist[i] = 0;
+        }
+        TASSERT ( sort_test_rows ( large_dist, large ) );
+        for ( unsigned int i = 0; i < large; i++ ) {
+            large_dist[i] = g_random_int_range ( 0, 16 );
+        }
+        TASSERT ( sort_test_rows ( large_dist, large ) );
+        TASSERT ( sort_test_partial ( large_dist, large, 300 ) );
+        for ( unsigned int i = 0; i < large; i++ ) {
+            large_dist[i] = g_random_int_range ( G_MININT, G_MAXINT );
+        }
+        TASSERT ( sort_test_rows ( large_dist, large ) );
+        TASSERT ( sort_test_partial ( large_dist, large, large / 2 ) );
+        TASSERT ( sort_test_merge ( large_dist, large, 1 ) );
+        TASSERT ( sort_test_merge ( large_dist, large, 32 ) );
+        for ( unsigned int i = 0; i < large; i++ ) {
+            large_dist[i] = g_random_int_range ( 0, 3 );
+        }
+        TASSERT ( sort_test_merge ( large_dist, large, 32 ) );
+        TASSERT ( sort_test_merge ( large_dist, 10, 4 ) );
+        TASSERT ( sort_test_merge ( large_dist, 0, 4 ) );
+        rofi_parallel_cleanup ();
+    }
+    g_free ( large_dist );
+    g_free ( distance );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,190 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <assert.h>
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "settings.h"
+#include "parallel.h"
+#include "trigram.h"
+
+static int test = 0;
+
+#define TASSERT( a )        {                            \
+        assert ( a );                                    \
+        printf ( "Test %i passed (%s)\n", ++test, # a ); \
+}
+
+/** Rows with two fields each, separated by a tab. */
+static char **rows     = NULL;
+static char **fields   = NULL;
+static unsigned int num_rows = 0;
+/** Every this many rows have no strings (like combi rows of a mode without match strings), 0 for none. */
+static unsigned int no_strings_step = 0;
+
+static gboolean trigram_test_no_strings ( unsigned int row )
+{
+    return no_strings_step > 0 && ( row % no_strings_step ) == 0;
+}
+
+static const char * trigram_test_text ( unsigned int row, unsigned int field, G_GNUC_UNUSED gpointer user_data )
+{
+    if ( trigram_test_no_strings ( row ) ) {
+        return NULL;
+    }
+    if ( field == 0 ) {
+        return rows[row];
+    }
+    return field == 1 ? fields[row] : NULL;
+}
+
+/**
+ * Check every row that contains all (ASCII case folded) literal parts of the pattern is a candidate.
+ * Rows without strings could match in any way, so they are always candidates.
+ */
+static gboolean trigram_test_query ( RofiTrigramIndex *index, const char *pattern, int method, gboolean case_sensitive, unsigned int *num_candidates )
+{
+    unsigned int *candidates = NULL;
+    unsigned int n           = 0;
+    if ( !rofi_trigram_index_query ( index, pattern, method, TRUE, case_sensitive, &candidates, &n ) ) {
+        return FALSE;
+    }
+    gchar        **parts = g_strsplit_set ( pattern, method == MM_GLOB ? " *?" : " ", 0 );
+    gboolean     retv    = TRUE;
+    unsigned int c       = 0;
+    for ( unsigned int row = 0; row < num_rows; row++ ) {
+        gboolean match = TRUE;
+        for ( unsigned int i = 0; match && !trigram_test_no_strings ( row ) && parts[i] != NULL; i++ ) {
+            match = g_strrstr ( rows[row], parts[i] ) != NULL || g_strrstr ( fields[row], parts[i] ) != NULL;
+            if ( !case_sensitive && !match ) {
+                gchar *a = g_ascii_strdown ( rows[row], -1 );
+                gchar *b = g_ascii_strdown ( fields[row], -1 );
+                gchar *p = g_ascii_strdown ( parts[i], -1 );
+                match = strstr ( a, p ) != NULL || strstr ( b, p ) != NULL;
+                g_free ( a );
+                g_free ( b );
+                g_free ( p );
+            }
+        }
+        while ( c < n && candidates[c] < row ) {
+            c++;
+        }
+        if ( match && ( c == n || candidates[c] != row ) ) {
+            retv = FALSE;
+        }
+    }
+    for ( unsigned int i = 1; i < n; i++ ) {
+        if ( candidates[i - 1] >= candidates[i] ) {
+            retv = FALSE;
+        }
+    }
+    g_strfreev ( parts );
+    g_free ( candidates );
+    *num_candidates = n;
+    return retv;
+}
+
+int main ( G_GNUC_UNUSED int argc, G_GNUC_UNUSED char **argv )
+{
+    static const char words[][8] = { "Rofi", "window", "run", "ssh", "drun", "term", "edit", "mail", "web", "Fïles" };
+    num_rows = 50000;
+    rows     = g_malloc0_n ( num_rows + 1, sizeof ( char* ) );
+    fields   = g_malloc0_n ( num_rows + 1, sizeof ( char* ) );
+    g_random_set_seed ( 42 );
+    for ( unsigned int i = 0; i < num_rows; i++ ) {
+        rows[i]   = g_strdup_printf ( "%s-%d %s", words[g_random_int_range ( 0, 10 )], g_random_int_range ( 0, 1000 ), words[g_random_int_range ( 0, 10 )] );
+        fields[i] = g_strdup_printf ( "%s%d", words[g_random_int_range ( 0, 10 )], i );
+    }
+
+    unsigned int workers[] = { 1, 4 };
+    for ( unsigned int w = 0; w < G_N_ELEMENTS ( workers ); w++ ) {
+        TASSERT ( rofi_parallel_init ( workers[w], NULL ) );
+        RofiTrigramIndex *index = rofi_trigram_index_new ( num_rows, trigram_test_text, NULL, NULL );
+        unsigned int     n      = 0;
+        TASSERT ( index != NULL );
+
+        TASSERT ( trigram_test_query ( index, "term", MM_NORMAL, TRUE, &n ) );
+        TASSERT ( n > 0 && n < num_rows );
+        TASSERT ( trigram_test_query ( index, "TERM", MM_NORMAL, FALSE, &n ) );
+        TASSERT ( n > 0 && n < num_rows );
+        TASSERT ( trigram_test_query ( index, "rofi-42 window", MM_NORMAL, FALSE, &n ) );
+        TASSERT ( trigram_test_query ( index, "rofi-42 window", MM_NORMAL, TRUE, &n ) );
+        TASSERT ( trigram_test_query ( index, fields[4999], MM_NORMAL, TRUE, &n ) );
+        TASSERT ( n >= 1 && n < 20 );
+        // Trigrams do not cross fields.
+        TASSERT ( trigram_test_query ( index, "ssh-1 zzz", MM_NORMAL, FALSE, &n ) );
+        TASSERT ( n == 0 );
+        TASSERT ( trigram_test_query ( index, "fïl", MM_NORMAL, TRUE, &n ) );
+        TASSERT ( n > 0 );
+        TASSERT ( trigram_test_query ( index, "ma*il-9?9", MM_GLOB, FALSE, &n ) );
+        TASSERT ( n > 0 );
+        TASSERT ( trigram_test_query ( index, "*drun*", MM_GLOB, TRUE, &n ) );
+        // Nothing to narrow down on.
+        TASSERT ( !trigram_test_query ( index, "ro fi", MM_NORMAL, TRUE, &n ) );
+        TASSERT ( !trigram_test_query ( index, "r*n", MM_GLOB, TRUE, &n ) );
+        TASSERT ( !trigram_test_query ( index, "ssh", MM_NORMAL, FALSE, &n ) );
+        TASSERT ( !trigram_test_query ( index, "term", MM_REGEX, TRUE, &n ) );
+        TASSERT ( !trigram_test_query ( index, "term", MM_FUZZY, TRUE, &n ) );
+        rofi_trigram_index_free ( index );
+        rofi_parallel_cleanup ();
+    }
+
+    // Rows without strings are candidates for every input.
+    {
+        no_strings_step = 97;
+        RofiTrigramIndex *index = rofi_trigram_index_new ( num_rows, trigram_test_text, NULL, NULL );
+        unsigned int     n      = 0;
+        TASSERT ( index != NULL );
+        TASSERT ( trigram_test_query ( index, "term", MM_NORMAL, TRUE, &n ) );
+        TASSERT ( trigram_test_query ( index, fields[4999], MM_NORMAL, TRUE, &n ) );
+        TASSERT ( n >= 1 + ( num_rows + 96 ) / 97 );
+        TASSERT ( trigram_test_query ( index, "ssh-1 zzz", MM_NORMAL, FALSE, &n ) );
+        TASSERT ( n == ( num_rows + 96 ) / 97 );
+        rofi_trigram_index_free ( index );
+        no_strings_step = 0;
+    }
+
+    // Cancelled before it got started.
+    gint cancel = TRUE;
+    TASSERT ( rofi_trigram_index_new ( num_rows, trigram_test_text, NULL, &cancel ) == NULL );
+
+    // Empty index.
+    num_rows = 0;
+    RofiTrigramIndex *index = rofi_trigram_index_new ( 0, trigram_test_text, NULL, NULL );
+    unsigned int     n      = 1;
+    TASSERT ( index != NULL );
+    TASSERT ( trigram_test_query ( index, "term", MM_NORMAL, TRUE, &n ) );
+    TASSERT ( n == 0 );
+    rofi_trigram_index_free ( index );
+
+    g_strfreev ( rows );
+    g_strfreev ( fields );
+    return EXIT_SUCCESS;
+}